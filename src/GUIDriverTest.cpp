@@ -0,0 +1,172 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "src/environment/GUIDriver.h"
+
+// Checks the damage regions that the GUI driver collects from the LVGL flushes,
+// the drivers upload exactly these rects to their textures.
+
+using avitab::GUIDriver;
+
+namespace {
+
+// Only keeps the frame buffer, nothing is shown
+class HeadlessGUIDriver: public GUIDriver {
+public:
+    void createWindow(const std::string &title) override {}
+    bool hasWindow() override { return true; }
+    void killWindow() override {}
+    void readPointerState(int &x, int &y, bool &pressed) override {}
+    int getWheelDirection() override { return 0; }
+    void setBrightness(float b) override {}
+    float getBrightness() override { return 1; }
+
+    void fill(int x1, int y1, int x2, int y2) {
+        std::vector<uint32_t> pixels((x2 - x1 + 1) * (y2 - y1 + 1), 0xFFFFFFFF);
+        blit(x1, y1, x2, y2, pixels.data());
+    }
+
+    using GUIDriver::takeDirtyRects;
+};
+
+constexpr const int WIDTH = 800;
+constexpr const int HEIGHT = 480;
+
+std::string toString(const std::vector<GUIDriver::DirtyRect> &rects) {
+    std::string res;
+    for (auto &r: rects) {
+        res += "[" + std::to_string(r.x1) + "," + std::to_string(r.y1) + " - "
+                + std::to_string(r.x2) + "," + std::to_string(r.y2) + "] ";
+    }
+    return res.empty() ? "none" : res;
+}
+
+bool expect(const char *test, HeadlessGUIDriver &driver, const std::vector<GUIDriver::DirtyRect> &expected) {
+    auto rects = driver.takeDirtyRects();
+
+    bool same = rects.size() == expected.size();
+    for (size_t i = 0; same && i < rects.size(); i++) {
+        same = rects[i].x1 == expected[i].x1 && rects[i].y1 == expected[i].y1
+            && rects[i].x2 == expected[i].x2 && rects[i].y2 == expected[i].y2;
+    }
+
+    if (!same) {
+        std::cerr << test << ": expected " << toString(expected) << "got " << toString(rects) << std::endl;
+    }
+    return same;
+}
+
+bool checkInit() {
+    HeadlessGUIDriver driver;
+    driver.init(WIDTH, HEIGHT);
+    return expect("init", driver, {{0, 0, WIDTH - 1, HEIGHT - 1}})
+        && expect("taken", driver, {});
+}
+
+bool checkMerge() {
+    HeadlessGUIDriver driver;
+    driver.init(WIDTH, HEIGHT);
+    driver.takeDirtyRects();
+
+    // overlapping rects become their bounding box, separate ones stay apart
+    driver.fill(10, 10, 29, 29);
+    driver.fill(20, 20, 39, 39);
+    driver.fill(100, 100, 109, 109);
+    return expect("overlap", driver, {{10, 10, 39, 39}, {100, 100, 109, 109}});
+}
+
+bool checkTouchMerge() {
+    HeadlessGUIDriver driver;
+    driver.init(WIDTH, HEIGHT);
+    driver.takeDirtyRects();
+
+    // adjacent rects can be uploaded in one go
+    driver.fill(10, 10, 19, 19);
+    driver.fill(20, 10, 29, 19);
+    if (!expect("touch left", driver, {{10, 10, 29, 19}})) {
+        return false;
+    }
+
+    driver.fill(10, 20, 19, 29);
+    driver.fill(10, 10, 19, 19);
+    if (!expect("touch below", driver, {{10, 10, 19, 29}})) {
+        return false;
+    }
+
+    // a gap of one pixel keeps them apart
+    driver.fill(10, 10, 19, 19);
+    driver.fill(21, 10, 29, 19);
+    if (!expect("gap", driver, {{10, 10, 19, 19}, {21, 10, 29, 19}})) {
+        return false;
+    }
+
+    // a rect that joins two existing ones merges all three
+    driver.fill(10, 10, 19, 19);
+    driver.fill(30, 10, 39, 19);
+    driver.fill(15, 15, 34, 24);
+    return expect("bridge", driver, {{10, 10, 39, 24}});
+}
+
+bool checkCollapse() {
+    HeadlessGUIDriver driver;
+    driver.init(WIDTH, HEIGHT);
+    driver.takeDirtyRects();
+
+    // up to 16 separate rects are kept
+    std::vector<GUIDriver::DirtyRect> expected;
+    for (int i = 0; i < 16; i++) {
+        driver.fill(i * 30, i * 20, i * 30 + 5, i * 20 + 5);
+        expected.push_back({i * 30, i * 20, i * 30 + 5, i * 20 + 5});
+    }
+    if (!expect("sixteen", driver, expected)) {
+        return false;
+    }
+
+    // one more collapses all of them into their bounding box
+    for (int i = 0; i < 17; i++) {
+        driver.fill(i * 30, i * 20, i * 30 + 5, i * 20 + 5);
+    }
+    return expect("collapse", driver, {{0, 0, 16 * 30 + 5, 16 * 20 + 5}});
+}
+
+bool checkSmallChange() {
+    HeadlessGUIDriver driver;
+    driver.init(WIDTH, HEIGHT);
+    driver.takeDirtyRects();
+
+    // a small change like a clock tick only damages its own area
+    driver.fill(WIDTH - 60, 0, WIDTH - 1, 15);
+    return expect("clock", driver, {{WIDTH - 60, 0, WIDTH - 1, 15}});
+}
+
+}
+
+int main() {
+    bool ok = true;
+    ok = checkInit() && ok;
+    ok = checkMerge() && ok;
+    ok = checkTouchMerge() && ok;
+    ok = checkCollapse() && ok;
+    ok = checkSmallChange() && ok;
+
+    std::cout << (ok ? "All damage regions match" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,120 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <string>
+#include "src/environment/MagneticModel.h"
+
+// Checks the magnetic model against the test values that NOAA publishes with
+// the WMM2020 coefficients in res/WMM.COF, and the grid against the full model.
+
+using avitab::MagneticModel;
+
+namespace {
+
+struct ReferenceValue {
+    double decimalYear, lat, lon, declination;
+};
+
+// WMM2020 test values at height 0 above the ellipsoid
+const ReferenceValue references[] = {
+    {2020.0,  80,   0, -1.28},
+    {2020.0,   0, 120,  0.16},
+    {2020.0, -80, 240, 69.36},
+};
+
+double wrap(double angle) {
+    angle = std::fmod(angle + 540, 360) - 180;
+    return angle;
+}
+
+bool checkReferences(const MagneticModel &model) {
+    bool ok = true;
+    for (auto &ref: references) {
+        double declination = model.computeDeclination(ref.lat, ref.lon, ref.decimalYear);
+        // the published values are rounded to 0.01 degrees
+        if (std::abs(wrap(declination - ref.declination)) > 0.006) {
+            std::cerr << "Reference " << ref.lat << ", " << ref.lon << " at " << ref.decimalYear
+                      << ": expected " << ref.declination << " got " << declination << std::endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+bool checkGrid(MagneticModel &model) {
+    model.buildGrid(2020.0);
+
+    bool ok = true;
+
+    // the reference positions are grid points
+    for (auto &ref: references) {
+        double declination = model.getDeclination(ref.lat, ref.lon);
+        if (std::abs(wrap(declination - ref.declination)) > 0.006) {
+            std::cerr << "Grid " << ref.lat << ", " << ref.lon << ": expected "
+                      << ref.declination << " got " << declination << std::endl;
+            ok = false;
+        }
+    }
+
+    // in between, the interpolation stays close to the model away from the magnetic poles,
+    // the declination changes too fast near them for a 1 degree grid
+    double worst = 0;
+    for (double lat = -50.25; lat <= 50; lat += 2.5) {
+        for (double lon = -179.75; lon <= 180; lon += 2.5) {
+            double diff = std::abs(wrap(model.getDeclination(lat, lon) - model.computeDeclination(lat, lon, 2020.0)));
+            worst = std::max(worst, diff);
+        }
+    }
+    std::cout << "Largest interpolation error: " << std::fixed << std::setprecision(3) << worst << std::endl;
+    if (worst > 0.1) {
+        std::cerr << "Grid interpolation is too far off" << std::endl;
+        ok = false;
+    }
+
+    // longitudes outside of -180..180 wrap around
+    if (std::abs(wrap(model.getDeclination(0, -240) - model.getDeclination(0, 120))) > 1e-6) {
+        std::cerr << "Grid doesn't wrap around the antimeridian" << std::endl;
+        ok = false;
+    }
+
+    return ok;
+}
+
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <WMM.COF>" << std::endl;
+        return 1;
+    }
+
+    bool ok = true;
+    try {
+        MagneticModel model(argv[1]);
+        ok = checkReferences(model) && ok;
+        ok = checkGrid(model) && ok;
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        ok = false;
+    }
+
+    std::cout << (ok ? "Magnetic model matches the reference values" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,178 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <random>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+#include "src/libxdata/parsers/AirportParser.h"
+#include "src/platform/Platform.h"
+
+// Measures how fast the nav data tokenizer gets through an apt.dat file. The real file
+// isn't redistributable, so a synthetic one with a similar mix of rows can be generated.
+// Most rows are taxiway and pavement rows that the parser only reads the row code of.
+
+namespace {
+
+int usage(const char *prog) {
+    std::cerr << "Usage: " << prog << " generate <apt.dat> <size in MB>" << std::endl;
+    std::cerr << "       " << prog << " parse <apt.dat> [runs]" << std::endl;
+    return 1;
+}
+
+class AptWriter {
+public:
+    AptWriter(const std::string &utf8Path):
+        out(fs::u8path(utf8Path), std::ios::out | std::ios::binary)
+    {
+    }
+
+    template<typename ... Args>
+    void line(const char *format, Args ... args) {
+        char buf[256];
+        int len = std::snprintf(buf, sizeof(buf), format, args...);
+        out.write(buf, std::min<int>(len, sizeof(buf) - 1));
+        out.put('\n');
+        written += len + 1;
+    }
+
+    bool ok() const { return (bool) out; }
+    size_t written = 0;
+private:
+    fs::ofstream out;
+};
+
+int generate(const std::string &path, size_t megabytes) {
+    AptWriter apt(path);
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<double> latDist(-60, 70), lonDist(-180, 180), offset(-0.02, 0.02);
+    std::uniform_int_distribution<int> elevDist(-50, 9000), countDist(10, 60);
+
+    apt.line("I");
+    apt.line("1100 Generated by AviTab-parserbench, synthetic data only");
+    apt.line("");
+
+    size_t limit = megabytes * 1024 * 1024;
+    for (int n = 0; apt.written < limit; n++) {
+        double lat = latDist(rng), lon = lonDist(rng);
+        char id[8];
+        std::snprintf(id, sizeof(id), "X%04d", n % 10000);
+
+        apt.line("1 %5d 0 0 %s Synthetic Airport %d", elevDist(rng), id, n);
+        apt.line("1302 city Synthetic City %d", n);
+        apt.line("1302 country Synthetic Country");
+        apt.line("1302 datum_lat %.8f", lat);
+        apt.line("1302 datum_lon %.8f", lon);
+        apt.line("1302 icao_code %s", id);
+        apt.line("1302 region_code XX");
+
+        apt.line("100 %6.2f 1 0 0.25 1 2 1 09L %12.8f %13.8f %7.2f %7.2f 3 0 0 0 27R %12.8f %13.8f %7.2f %7.2f 3 0 0 0",
+                45.0, lat, lon, 0.0, 0.0, lat + offset(rng), lon + offset(rng), 120.0, 0.0);
+        apt.line("100 %6.2f 2 0 0.25 0 0 0 18 %12.8f %13.8f %7.2f %7.2f 1 0 0 0 36 %12.8f %13.8f %7.2f %7.2f 1 0 0 0",
+                30.0, lat + offset(rng), lon + offset(rng), 0.0, 0.0, lat + offset(rng), lon + offset(rng), 0.0, 0.0);
+        apt.line("102 H1 %12.8f %13.8f 90.00 20.00 20.00 2 0 0 0.25 0", lat + offset(rng), lon + offset(rng));
+        apt.line("1050 127850 ATIS");
+        apt.line("1051 121700 GND");
+        apt.line("1052 118300 TWR");
+
+        // pavement outlines and the taxi route network make up most of the real file
+        int nodes = countDist(rng);
+        apt.line("110 1 0.25 150.29 Taxiway %d", n);
+        for (int i = 0; i < nodes; i++) {
+            if (i % 3 == 0) {
+                apt.line("112 %12.8f %13.8f %12.8f %13.8f 1 102", lat + offset(rng), lon + offset(rng), lat + offset(rng), lon + offset(rng));
+            } else {
+                apt.line("111 %12.8f %13.8f 1", lat + offset(rng), lon + offset(rng));
+            }
+        }
+        apt.line("113 %12.8f %13.8f", lat + offset(rng), lon + offset(rng));
+
+        apt.line("1200");
+        for (int i = 0; i < nodes; i++) {
+            apt.line("1201 %12.8f %13.8f both %d A%d", lat + offset(rng), lon + offset(rng), i, i);
+        }
+        for (int i = 1; i < nodes; i++) {
+            apt.line("1202 %d %d twoway taxiway A", i - 1, i);
+        }
+    }
+    apt.line("99");
+
+    if (!apt.ok()) {
+        std::cerr << "Couldn't write " << path << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << apt.written / (1024 * 1024) << " MB to " << path << std::endl;
+    return 0;
+}
+
+int parse(const std::string &path, int runs) {
+    double size = fs::file_size(fs::u8path(path)) / (1024.0 * 1024.0);
+    double best = 0;
+
+    for (int run = 0; run < runs; run++) {
+        size_t airports = 0, runways = 0;
+        auto start = std::chrono::steady_clock::now();
+
+        xdata::AirportParser parser(path);
+        parser.setAcceptor([&airports, &runways] (const xdata::AirportData &port) {
+            airports++;
+            runways += port.runways.size();
+        });
+        parser.loadAirports();
+
+        std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+        if (run == 0 || secs.count() < best) {
+            best = secs.count();
+        }
+
+        std::cout << "Run " << run + 1 << ": " << airports << " airports, " << runways << " runways in "
+                  << std::fixed << std::setprecision(3) << secs.count() << " s" << std::endl;
+    }
+
+    std::cout << "Best: " << std::fixed << std::setprecision(3) << best << " s, "
+              << std::setprecision(1) << size / best << " MB/s" << std::endl;
+    return 0;
+}
+
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        return usage(argv[0]);
+    }
+
+    std::string command = argv[1];
+    std::string path = argv[2];
+
+    try {
+        if (command == "generate" && argc == 4) {
+            return generate(path, std::stoul(argv[3]));
+        } else if (command == "parse" && argc <= 4) {
+            return parse(path, argc == 4 ? std::max(1, std::stoi(argv[3])) : 3);
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return usage(argv[0]);
+}
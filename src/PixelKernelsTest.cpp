@@ -0,0 +1,225 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include "src/libimg/PixelKernels.h"
+
+// Checks that the pixel kernels of each instruction set supported by this machine
+// produce exactly the same pixels as the scalar code they replaced. All pairs of
+// foreground and background alpha are combined with all pairs of channel values.
+
+using img::SimdLevel;
+
+namespace {
+
+// Image::blendPixel before the kernels were introduced
+uint32_t referenceBlend(uint32_t color, uint32_t foreCol) {
+    float ba = (int) ((color >> 24) & 0xFF) / 255.0;
+    float br = (int) ((color >> 16) & 0xFF) / 255.0;
+    float bg = (int) ((color >>  8) & 0xFF) / 255.0;
+    float bb = (int) ((color >>  0) & 0xFF) / 255.0;
+
+    float fa = (int) ((foreCol >> 24) & 0xFF) / 255.0;
+    float fr = (int) ((foreCol >> 16) & 0xFF) / 255.0;
+    float fg = (int) ((foreCol >>  8) & 0xFF) / 255.0;
+    float fb = (int) ((foreCol >>  0) & 0xFF) / 255.0;
+
+    float a = fa + ba * (1 - fa);
+    float r = (fr * fa + br * ba * (1 - fa)) / a;
+    float g = (fg * fa + bg * ba * (1 - fa)) / a;
+    float b = (fb * fa + bb * ba * (1 - fa)) / a;
+
+    return (uint8_t(a * 255) << 24)
+            | (uint8_t(r * 255) << 16)
+            | (uint8_t(g * 255) << 8)
+            | (uint8_t(b * 255) << 0);
+}
+
+uint32_t makeColor(int a, int r, int g, int b) {
+    return ((a & 0xFF) << 24) | ((r & 0xFF) << 16) | ((g & 0xFF) << 8) | (b & 0xFF);
+}
+
+// one pixel per foreground channel value and background channel triple,
+// the three background channels together cover all 256 values
+constexpr int BACK_STEPS = 86;
+
+void fillColors(int foreAlpha, int backAlpha, std::vector<uint32_t> &fore, std::vector<uint32_t> &back) {
+    fore.clear();
+    back.clear();
+    for (int fc = 0; fc < 256; fc++) {
+        for (int bc = 0; bc < BACK_STEPS; bc++) {
+            fore.push_back(makeColor(foreAlpha, fc, fc, fc));
+            back.push_back(makeColor(backAlpha, bc, bc + BACK_STEPS, bc + 2 * BACK_STEPS));
+        }
+    }
+}
+
+const char *levelName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::NONE:   return "scalar";
+    case SimdLevel::SSE2:   return "SSE2";
+    case SimdLevel::AVX2:   return "AVX2";
+    }
+    return "unknown";
+}
+
+bool report(const char *test, SimdLevel level, uint32_t back, uint32_t fore, uint32_t expected, uint32_t actual) {
+    std::cerr << test << " (" << levelName(level) << "): back " << std::hex << back << " fore " << fore
+              << " expected " << expected << " got " << actual << std::dec << std::endl;
+    return false;
+}
+
+bool checkConvert(SimdLevel level) {
+    // all byte values in all positions, the odd length also covers the scalar tail
+    std::vector<uint8_t> rgba;
+    for (int i = 0; i < 256 + 3; i++) {
+        rgba.insert(rgba.end(), {uint8_t(i), uint8_t(i + 85), uint8_t(i + 170), uint8_t(255 - i)});
+    }
+
+    size_t count = rgba.size() / 4;
+    std::vector<uint32_t> argb(count);
+    img::setSimdLevel(level);
+    img::convertRGBAToARGB(rgba.data(), argb.data(), count);
+
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t *p = &rgba[i * 4];
+        uint32_t expected = (p[3] << 24) | (p[0] << 16) | (p[1] << 8) | p[2];
+        if (argb[i] != expected) {
+            return report("convertRGBAToARGB", level, 0, i, expected, argb[i]);
+        }
+    }
+    return true;
+}
+
+bool checkTails(SimdLevel level) {
+    // lengths that aren't a multiple of the vector width
+    img::setSimdLevel(level);
+    for (size_t count = 1; count <= 17; count++) {
+        std::vector<uint32_t> fore, back;
+        for (size_t i = 0; i < count; i++) {
+            fore.push_back(makeColor(i * 37, i * 11, i * 101, i * 53));
+            back.push_back(makeColor(255 - i * 13, i * 7, i * 59, i * 91));
+        }
+
+        std::vector<uint32_t> res = back;
+        img::blendSpan(res.data(), fore.data(), count);
+        for (size_t i = 0; i < count; i++) {
+            uint32_t expected = (fore[i] & 0xFF000000) ? referenceBlend(back[i], fore[i]) : back[i];
+            if (res[i] != expected) {
+                return report("blendSpan tail", level, back[i], fore[i], expected, res[i]);
+            }
+        }
+
+        res = fore;
+        img::blendSpanOverColor(res.data(), count, back[0]);
+        for (size_t i = 0; i < count; i++) {
+            uint32_t expected = referenceBlend(back[0], fore[i]);
+            if (res[i] != expected) {
+                return report("blendSpanOverColor tail", level, back[0], fore[i], expected, res[i]);
+            }
+        }
+    }
+    return true;
+}
+
+// The reference is slow, so each batch is computed once and compared with all levels
+
+bool checkBlendSpan(const std::vector<SimdLevel> &levels) {
+    std::vector<uint32_t> fore, back, expected, res;
+    for (int fa = 0; fa < 256; fa++) {
+        for (int ba = 0; ba < 256; ba++) {
+            fillColors(fa, ba, fore, back);
+            expected = back;
+            for (size_t i = 0; i < fore.size(); i++) {
+                if (fore[i] & 0xFF000000) {
+                    expected[i] = referenceBlend(back[i], fore[i]);
+                }
+            }
+
+            for (SimdLevel level: levels) {
+                img::setSimdLevel(level);
+                res = back;
+                img::blendSpan(res.data(), fore.data(), res.size());
+                for (size_t i = 0; i < res.size(); i++) {
+                    if (res[i] != expected[i]) {
+                        return report("blendSpan", level, back[i], fore[i], expected[i], res[i]);
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool checkBlendSpanOverColor(const std::vector<SimdLevel> &levels) {
+    // each call uses one background color, so the loops are swapped
+    std::vector<uint32_t> fore, expected, res;
+    for (int fa = 0; fa < 256; fa++) {
+        for (int fc = 0; fc < 256; fc++) {
+            fore.push_back(makeColor(fa, fc, fc, fc));
+        }
+    }
+
+    expected.resize(fore.size());
+    for (int ba = 0; ba < 256; ba++) {
+        for (int bc = 0; bc < BACK_STEPS; bc++) {
+            uint32_t background = makeColor(ba, bc, bc + BACK_STEPS, bc + 2 * BACK_STEPS);
+            for (size_t i = 0; i < fore.size(); i++) {
+                expected[i] = referenceBlend(background, fore[i]);
+            }
+
+            for (SimdLevel level: levels) {
+                img::setSimdLevel(level);
+                res = fore;
+                img::blendSpanOverColor(res.data(), res.size(), background);
+                for (size_t i = 0; i < res.size(); i++) {
+                    if (res[i] != expected[i]) {
+                        return report("blendSpanOverColor", level, background, fore[i], expected[i], res[i]);
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+}
+
+int main() {
+    std::vector<SimdLevel> levels;
+    for (SimdLevel level: {SimdLevel::NONE, SimdLevel::SSE2, SimdLevel::AVX2}) {
+        if (img::setSimdLevel(level)) {
+            levels.push_back(level);
+            std::cout << "Checking " << levelName(level) << std::endl;
+        } else {
+            std::cout << levelName(level) << " not supported, skipped" << std::endl;
+        }
+    }
+
+    bool ok = true;
+    for (SimdLevel level: levels) {
+        ok = checkConvert(level) && checkTails(level) && ok;
+    }
+    ok = checkBlendSpan(levels) && ok;
+    ok = checkBlendSpanOverColor(levels) && ok;
+
+    img::setSimdLevel(img::getSupportedSimdLevel());
+    std::cout << (ok ? "All kernels match the reference" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -43,6 +43,7 @@ PLUGIN_API int XPluginStart(char *outName, char *outSignature, char *outDescript
         logger::setStdOut(environment->getConfig()->getBool("/AviTab/logToStdOut"));
         logger::init(environment->getProgramPath());
         environment->loadSettings();
+        environment->loadMagneticModelInBackground();
         strncpy(outDescription, "A tablet to help in VR.", 255);
     } catch (const std::exception &e) {
         try {
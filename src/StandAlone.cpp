@@ -34,6 +34,7 @@ int main() {
         logger::init(env->getProgramPath());
         logger::verbose("Main thread has id %d", std::this_thread::get_id());
         env->loadSettings();
+        env->loadMagneticModelInBackground();
 
         auto aviTab = std::make_unique<avitab::AviTab>(env);
         aviTab->startApp();
@@ -0,0 +1,160 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <iostream>
+#include <vector>
+#include <string>
+#include "src/libimg/stitcher/TilePack.h"
+#include "src/platform/Platform.h"
+
+// Imports an existing per-file tile cache into the tile pack of the same directory.
+// Only downloaded tiles are imported: MapTiles also contains user provided maps.
+// The compact command drops tiles that were replaced by newer downloads.
+
+namespace {
+
+const std::vector<std::string> defaultSubDirs = {
+    "a.tile.opentopomap.org", // OpenTopoMap
+    "hd-1x", "hn-1x", "ld-1x", "ln-1x", // Navigraph
+};
+
+int usage(const char *prog) {
+    std::cerr << "Usage: " << prog << " import <MapTiles directory> [--remove] [sub directory...]" << std::endl;
+    std::cerr << "       " << prog << " compact <MapTiles directory>" << std::endl;
+    std::cerr << "Default sub directories:";
+    for (auto &dir: defaultSubDirs) {
+        std::cerr << " " << dir;
+    }
+    std::cerr << std::endl;
+    return 1;
+}
+
+bool readFile(const fs::path &path, std::vector<uint8_t> &data) {
+    fs::ifstream in(path, std::ios::in | std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    return !in.bad();
+}
+
+int compact(const std::string &baseDir) {
+    if (!img::TilePack::exists(baseDir)) {
+        std::cerr << "No tile pack in " << baseDir << std::endl;
+        return 1;
+    }
+
+    try {
+        uint64_t saved = img::TilePack::compact(baseDir);
+        std::cout << "Compacted tile pack, saved " << saved / 1024 << " KiB" << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+}
+
+int main(int argc, char **argv) {
+    if (argc == 3 && std::string(argv[1]) == "compact") {
+        // AviTab must not be running, it keeps the pack open
+        return compact(argv[2]);
+    }
+
+    if (argc < 3 || std::string(argv[1]) != "import") {
+        return usage(argv[0]);
+    }
+
+    std::string baseDir = argv[2];
+    bool removeFiles = false;
+    std::vector<std::string> subDirs;
+    for (int i = 3; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--remove") {
+            removeFiles = true;
+        } else {
+            subDirs.push_back(arg);
+        }
+    }
+
+    if (subDirs.empty()) {
+        subDirs = defaultSubDirs;
+    }
+
+    if (!platform::fileExists(baseDir)) {
+        std::cerr << "Directory not found: " << baseDir << std::endl;
+        return 1;
+    }
+
+    int imported = 0, skipped = 0, failed = 0;
+    try {
+        auto pack = img::TilePack::open(baseDir);
+        fs::path basePath = fs::u8path(baseDir);
+
+        for (auto &subDir: subDirs) {
+            fs::path dirPath = basePath / fs::u8path(subDir);
+            if (!fs::is_directory(dirPath)) {
+                continue;
+            }
+
+            std::cout << "Importing " << dirPath.u8string() << std::endl;
+
+            std::vector<fs::path> importedFiles;
+            for (auto &entry: fs::recursive_directory_iterator(dirPath)) {
+                if (!entry.is_regular_file()) {
+                    continue;
+                }
+
+                // same name as TileSource::getUniqueTileName
+                std::string name = fs::relative(entry.path(), basePath).generic_u8string();
+                if (pack->hasTile(name)) {
+                    skipped++;
+                    importedFiles.push_back(entry.path());
+                    continue;
+                }
+
+                std::vector<uint8_t> data;
+                if (!readFile(entry.path(), data) || data.empty()) {
+                    std::cerr << "Couldn't read " << entry.path().u8string() << std::endl;
+                    failed++;
+                    continue;
+                }
+
+                pack->writeTile(name, data);
+                importedFiles.push_back(entry.path());
+                imported++;
+            }
+
+            if (removeFiles) {
+                // not while iterating the directory
+                for (auto &path: importedFiles) {
+                    std::error_code ec;
+                    fs::remove(path, ec);
+                }
+            }
+        }
+
+        std::cout << "Imported " << imported << " tiles, " << skipped << " already in pack, "
+                  << failed << " failed, " << pack->getTileCount() << " tiles in pack" << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,197 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <csignal>
+#include <curl/curl.h>
+#include "src/libimg/stitcher/TileSeeder.h"
+#include "src/maps/sources/OpenTopoSource.h"
+#include "src/maps/sources/XPlaneSource.h"
+#include "src/maps/sources/GeoTIFFSource.h"
+#include "src/maps/sources/PDFSource.h"
+#include "src/platform/Platform.h"
+
+// Stores the tiles of a region in a MapTiles directory so that AviTab doesn't have to
+// download or render them during a flight. Run it again to resume an interrupted run.
+
+namespace {
+
+volatile std::sig_atomic_t interrupted = 0;
+
+void onInterrupt(int) {
+    interrupted = 1;
+}
+
+int usage(const char *prog) {
+    std::cerr << "Usage: " << prog << " <MapTiles directory> <map> --zoom <min>-<max> [options]" << std::endl;
+    std::cerr << "Maps:" << std::endl;
+    std::cerr << "  opentopo" << std::endl;
+    std::cerr << "  xplane <earth texture directory>" << std::endl;
+    std::cerr << "  geotiff <file>" << std::endl;
+    std::cerr << "  mercator <calibrated PDF or image>" << std::endl;
+    std::cerr << "Options:" << std::endl;
+    std::cerr << "  --area <lat1>,<lon1>,<lat2>,<lon2>  rectangle to store" << std::endl;
+    std::cerr << "  --via <lat>,<lon>                   next point of a route to store, repeatable" << std::endl;
+    std::cerr << "  --page <n>                          page of the map, default 0" << std::endl;
+    std::cerr << "  --threads <n>                       default one per CPU core" << std::endl;
+    return 1;
+}
+
+std::shared_ptr<img::TileSource> createSource(const std::string &type, const std::string &arg) {
+    if (type == "opentopo") {
+        return std::make_shared<maps::OpenTopoSource>();
+    } else if (type == "xplane") {
+        return std::make_shared<maps::XPlaneSource>(arg);
+    } else if (type == "geotiff") {
+        return std::make_shared<maps::GeoTIFFSource>(arg);
+    } else if (type == "mercator") {
+        return std::make_shared<maps::PDFSource>(arg);
+    }
+    throw std::runtime_error("Unknown map: " + type);
+}
+
+std::vector<double> parseNumbers(const std::string &str, size_t count) {
+    std::vector<double> res;
+    size_t pos = 0;
+    while (pos <= str.size()) {
+        size_t end = str.find(',', pos);
+        if (end == std::string::npos) {
+            end = str.size();
+        }
+        res.push_back(std::stod(str.substr(pos, end - pos)));
+        pos = end + 1;
+    }
+
+    if (res.size() != count) {
+        throw std::invalid_argument("Expected " + std::to_string(count) + " numbers: " + str);
+    }
+    return res;
+}
+
+void printProgress(const img::TileSeeder::Progress &progress) {
+    size_t done = progress.stored + progress.skipped + progress.failed;
+    std::cout << "\r" << done << " / " << progress.total << " tiles, "
+              << progress.stored << " stored, " << progress.skipped << " already stored, "
+              << progress.failed << " failed, " << std::fixed << std::setprecision(1)
+              << progress.getTilesPerSecond() << " tiles/s   " << std::flush;
+}
+
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        return usage(argv[0]);
+    }
+
+    std::string cacheDir = argv[1];
+    std::string mapType = argv[2];
+    int argIndex = 3;
+
+    std::string mapArg;
+    if (mapType != "opentopo") {
+        if (argc < 4) {
+            return usage(argv[0]);
+        }
+        mapArg = argv[argIndex++];
+    }
+
+    int minZoom = 0, maxZoom = -1;
+    int page = 0;
+    int threads = 0;
+    std::vector<double> area;
+    std::vector<img::Point<double>> route;
+
+    try {
+        for (; argIndex < argc; argIndex++) {
+            std::string arg = argv[argIndex];
+            if (argIndex + 1 >= argc) {
+                return usage(argv[0]);
+            }
+            std::string value = argv[++argIndex];
+
+            if (arg == "--zoom") {
+                size_t dash = value.find('-', 1);
+                minZoom = std::stoi(value.substr(0, dash));
+                maxZoom = (dash == std::string::npos) ? minZoom : std::stoi(value.substr(dash + 1));
+            } else if (arg == "--area") {
+                area = parseNumbers(value, 4);
+            } else if (arg == "--via") {
+                auto latLon = parseNumbers(value, 2);
+                route.push_back(img::Point<double>{latLon[1], latLon[0]});
+            } else if (arg == "--page") {
+                page = std::stoi(value);
+            } else if (arg == "--threads") {
+                threads = std::stoi(value);
+            } else {
+                return usage(argv[0]);
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Invalid argument: " << e.what() << std::endl;
+        return usage(argv[0]);
+    }
+
+    if (maxZoom < minZoom || (area.empty() && route.empty())) {
+        return usage(argv[0]);
+    }
+
+    curl_global_init(CURL_GLOBAL_ALL);
+
+    img::TileSeeder::Progress progress;
+    try {
+        auto source = createSource(mapType, mapArg);
+        img::TileSeeder seeder(source, cacheDir);
+
+        if (!area.empty()) {
+            seeder.addWorldArea(page, img::Point<double>{area[1], area[0]}, img::Point<double>{area[3], area[2]}, minZoom, maxZoom);
+        }
+
+        if (!route.empty()) {
+            seeder.addWorldPath(page, route, minZoom, maxZoom);
+        }
+
+        std::signal(SIGINT, onInterrupt);
+        seeder.start(threads);
+
+        do {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            if (interrupted) {
+                std::cout << std::endl << "Stopping, run again to continue" << std::endl;
+                seeder.cancel();
+            }
+            progress = seeder.getProgress();
+            printProgress(progress);
+        } while (progress.running);
+
+        seeder.wait();
+        std::cout << std::endl << "Finished in " << std::fixed << std::setprecision(1) << progress.seconds << " s" << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        curl_global_cleanup();
+        return 1;
+    }
+
+    curl_global_cleanup();
+
+    return (progress.failed == 0 && !interrupted) ? 0 : 1;
+}
@@ -32,6 +32,7 @@ AviTab::AviTab(std::shared_ptr<Environment> environment):
 {
     // runs in environment thread, called by PluginStart
     img::TTFStamper::setFontDirectory(env->getFontDirectory());
+    guiLib->setMaxFrameRate(env->getSettings()->getGeneralSetting<int>("gui_max_fps"));
     if (env->getConfig()->getBool("/AviTab/loadNavData")) {
         env->loadNavWorldInBackground();
     }
@@ -368,6 +369,14 @@ void AviTab::loadUserFixes(std::string filename) {
     env->loadUserFixes(filename);
 }
 
+void AviTab::setActiveRoute(std::shared_ptr<xdata::Route> route) {
+    activeRoute = route;
+}
+
+std::shared_ptr<xdata::Route> AviTab::getActiveRoute() {
+    return activeRoute;
+}
+
 std::shared_ptr<apis::ChartService> AviTab::getChartService() {
     return chartService;
 }
@@ -384,6 +393,14 @@ float AviTab::getLastFrameTime() {
     return env->getLastFrameTime();
 }
 
+void AviTab::subscribeData(const std::string& dataRef) {
+    env->subscribeData(dataRef);
+}
+
+EnvData AviTab::getSubscribedData(const std::string& dataRef) {
+    return env->getSubscribedData(dataRef);
+}
+
 std::shared_ptr<Settings> AviTab::getSettings() {
     return env->getSettings();
 }
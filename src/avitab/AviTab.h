@@ -61,12 +61,16 @@ public:
     double getMagneticVariation(double lat, double lon) override;
     void reloadMetar() override;
     void loadUserFixes(std::string filename) override;
+    void setActiveRoute(std::shared_ptr<xdata::Route> route) override;
+    std::shared_ptr<xdata::Route> getActiveRoute() override;
     void close() override;
     void setIsInMenu(bool inMenu) override;
     std::shared_ptr<apis::ChartService> getChartService() override;
     AircraftID getActiveAircraftCount() override;
     Location getAircraftLocation(AircraftID id) override;
     float getLastFrameTime() override;
+    void subscribeData(const std::string &dataRef) override;
+    EnvData getSubscribedData(const std::string &dataRef) override;
     std::shared_ptr<Settings> getSettings() override;
 
     ~AviTab();
@@ -85,6 +89,7 @@ private:
 
     std::shared_ptr<apis::ChartService> chartService;
     std::shared_ptr<js::Runtime> jsRuntime;
+    std::shared_ptr<xdata::Route> activeRoute;
 
     void createPanel();
     void createLayout();
@@ -22,6 +22,7 @@
 #include <string>
 #include "src/gui_toolkit/widgets/Container.h"
 #include "src/libxdata/world/World.h"
+#include "src/libxdata/router/Route.h"
 #include "src/charts/ChartService.h"
 #include "src/environment/Environment.h"
 
@@ -52,6 +53,8 @@ public:
     virtual std::shared_ptr<xdata::World> getNavWorld() = 0;
     virtual void reloadMetar() = 0;
     virtual void loadUserFixes(std::string filename) = 0;
+    virtual void setActiveRoute(std::shared_ptr<xdata::Route> route) = 0;
+    virtual std::shared_ptr<xdata::Route> getActiveRoute() = 0;
     virtual double getMagneticVariation(double lat, double lon) = 0;
     virtual void close() = 0;
     virtual void setIsInMenu(bool inMenu) = 0;
@@ -59,6 +62,8 @@ public:
     virtual unsigned int getActiveAircraftCount() = 0;
     virtual Location getAircraftLocation(AircraftID id) = 0;
     virtual float getLastFrameTime() = 0;
+    virtual void subscribeData(const std::string &dataRef) = 0;
+    virtual EnvData getSubscribedData(const std::string &dataRef) = 0;
     virtual std::shared_ptr<Settings> getSettings() = 0;
     virtual ~AppFunctions() = default;
 };
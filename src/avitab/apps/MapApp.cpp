@@ -117,6 +117,14 @@ void MapApp::createSettingsLayout() {
     auto mercatorLabel = std::make_shared<Label>(settingsContainer, "Uses any PDF or image as Mercator map.");
     mercatorLabel->alignRightOf(mercatorButton, 10);
     mercatorLabel->setManaged();
+
+    offlineButton = std::make_shared<Button>(settingsContainer, "Offline");
+    offlineButton->setCallback([this] (const Button &) { onOfflineButton(); });
+    offlineButton->setFit(false, true);
+    offlineButton->setDimensions(openTopoButton->getWidth(), openTopoButton->getHeight());
+    offlineButton->alignBelow(mercatorButton, 10);
+    offlineLabel = std::make_shared<Label>(settingsContainer, "Stores the visible area and the active route\nfor offline use. Press again to stop.");
+    offlineLabel->alignRightOf(offlineButton, 10);
 }
 
 void MapApp::setMapSource(MapSource style) {
@@ -125,11 +133,11 @@ void MapApp::setMapSource(MapSource style) {
     switch (style) {
     case MapSource::OPEN_TOPO:
         newSource = std::make_shared<maps::OpenTopoSource>();
-        setTileSource(newSource);
+        setTileSource(newSource, [] () { return std::make_shared<maps::OpenTopoSource>(); });
         break;
     case MapSource::XPLANE:
         newSource = std::make_shared<maps::XPlaneSource>(api().getEarthTexturePath());
-        setTileSource(newSource);
+        setTileSource(newSource, [this] () { return std::make_shared<maps::XPlaneSource>(api().getEarthTexturePath()); });
         break;
     case MapSource::GEOTIFF:
         selectGeoTIFF();
@@ -159,7 +167,7 @@ void MapApp::selectGeoTIFF() {
         api().executeLater([this, selectedUTF8] () {
             try {
                 auto geoSource = std::make_shared<maps::GeoTIFFSource>(selectedUTF8);
-                setTileSource(geoSource);
+                setTileSource(geoSource, [selectedUTF8] () { return std::make_shared<maps::GeoTIFFSource>(selectedUTF8); });
                 fileChooser.reset();
                 chooserContainer->setVisible(false);
             } catch (const std::exception &e) {
@@ -185,7 +193,7 @@ void MapApp::selectMercator() {
         api().executeLater([this, selectedUTF8] () {
             try {
                 auto pdfSource = std::make_shared<maps::PDFSource>(selectedUTF8);
-                setTileSource(pdfSource);
+                setTileSource(pdfSource, [selectedUTF8] () { return std::make_shared<maps::PDFSource>(selectedUTF8); });
                 fileChooser.reset();
                 chooserContainer->setVisible(false);
             } catch (const std::exception &e) {
@@ -234,22 +242,30 @@ void MapApp::selectNavigraph(bool highEnroute) {
     setTileSource(source);
 }
 
-void MapApp::setTileSource(std::shared_ptr<img::TileSource> source) {
+void MapApp::setTileSource(std::shared_ptr<img::TileSource> source, SourceFactory offlineFactory) {
     mapImage->clear(img::COLOR_TRANSPARENT);
     map.reset();
+    prefetcher.reset();
     mapStitcher.reset();
     tileSource = source;
+    offlineSourceFactory = offlineFactory;
 
     trackPlane = true;
 
     mapStitcher = std::make_shared<img::Stitcher>(mapImage, tileSource);
-    mapStitcher->setCacheDirectory(api().getDataPath() + "MapTiles/");
+    // optional tier of decoded tiles, trades disk space for decode time
+    size_t rawCacheMB = std::max(0, savedSettings->getGeneralSetting<int>("raw_tile_cache_mb"));
+    mapStitcher->setCacheDirectory(api().getDataPath() + "MapTiles/", rawCacheMB * 1024 * 1024);
 
     map = std::make_shared<maps::OverlayedMap>(mapStitcher, overlayConf);
     map->loadOverlayIcons(api().getDataPath() + "icons/");
     map->setRedrawCallback([this] () { onRedrawNeeded(); });
     map->setNavWorld(api().getNavWorld());
 
+    if (tileSource->supportsPrefetch()) {
+        prefetcher = std::make_shared<maps::TilePrefetcher>(mapStitcher);
+    }
+
     keyboard.reset();
     coordsField.reset();
 
@@ -292,7 +308,7 @@ void MapApp::onSettingsButton() {
         naviLowButton->setCallback([this] (const Button &) { setMapSource(MapSource::NAVIGRAPH_LOW); });
         naviLowButton->setFit(false, true);
         naviLowButton->setDimensions(openTopoButton->getWidth(), openTopoButton->getHeight());
-        naviLowButton->alignBelow(mercatorButton, 10);
+        naviLowButton->alignBelow(offlineButton, 10);
         auto naviLowLabel = std::make_shared<Label>(settingsContainer, "Navigraph low enroute charts");
         naviLowLabel->alignRightOf(naviLowButton, 10);
         naviLowLabel->setManaged();
@@ -310,6 +326,76 @@ void MapApp::onSettingsButton() {
     settingsContainer->setVisible(!settingsContainer->isVisible());
 }
 
+void MapApp::onOfflineButton() {
+    if (seeder && seeder->getProgress().running) {
+        seeder->cancel();
+        return;
+    }
+
+    seeder.reset();
+
+    if (!offlineSourceFactory || !mapStitcher) {
+        offlineLabel->setText("This map can't be stored for offline use.");
+        return;
+    }
+
+    try {
+        auto newSeeder = std::make_unique<img::TileSeeder>(offlineSourceFactory(), api().getDataPath() + "MapTiles/");
+
+        // the visible area, also if rotated
+        int page = mapStitcher->getCurrentPage();
+        int zoom = mapStitcher->getZoomLevel();
+        auto center = mapStitcher->getCenter();
+        auto tileDim = tileSource->getTileDimensions(zoom);
+        double halfSize = std::max(mapImage->getWidth(), mapImage->getHeight()) / 2.0;
+        img::Point<double> topLeft{center.x - halfSize / tileDim.x, center.y - halfSize / tileDim.y};
+        img::Point<double> bottomRight{center.x + halfSize / tileDim.x, center.y + halfSize / tileDim.y};
+        newSeeder->addArea(page, topLeft, bottomRight, zoom, zoom, zoom + OFFLINE_EXTRA_ZOOM_LEVELS);
+
+        auto route = api().getActiveRoute();
+        if (route && tileSource->supportsWorldCoords()) {
+            std::vector<img::Point<double>> path;
+            route->iterateRoute([&path] (const std::shared_ptr<xdata::NavEdge> via, const std::shared_ptr<xdata::NavNode> to) {
+                if (to) {
+                    auto &loc = to->getLocation();
+                    path.push_back(img::Point<double>{loc.longitude, loc.latitude});
+                }
+            });
+            newSeeder->addWorldPath(page, path, zoom, zoom + OFFLINE_EXTRA_ZOOM_LEVELS);
+        }
+
+        if (newSeeder->getTileCount() > MAX_OFFLINE_TILES) {
+            offlineLabel->setTextFormatted("Too many tiles (%d), zoom out or use\nthe AviTab-tileseed tool.", (int) newSeeder->getTileCount());
+            return;
+        }
+
+        newSeeder->start();
+        seeder = std::move(newSeeder);
+        seederReported = false;
+        updateOfflineProgress();
+    } catch (const std::exception &e) {
+        logger::warn("Couldn't store map for offline use: %s", e.what());
+        offlineLabel->setText(std::string("Error: ") + e.what());
+    }
+}
+
+void MapApp::updateOfflineProgress() {
+    if (!seeder || seederReported) {
+        return;
+    }
+
+    auto progress = seeder->getProgress();
+    size_t done = progress.stored + progress.skipped + progress.failed;
+    if (progress.running) {
+        offlineLabel->setTextFormatted("Storing tiles: %d / %d\n%.1f tiles/s. Press again to stop.",
+                (int) done, (int) progress.total, progress.getTilesPerSecond());
+    } else {
+        offlineLabel->setTextFormatted("Stored %d / %d tiles in %.0f s\n%d failed, press again to resume.",
+                (int) (progress.stored + progress.skipped), (int) progress.total, progress.seconds, (int) progress.failed);
+        seederReported = true;
+    }
+}
+
 void MapApp::onOverlaysButton() {
     if (overlaysContainer) {
         resetWidgets();
@@ -620,6 +706,8 @@ void MapApp::processCalibrationPoint(int step) {
 }
 
 bool MapApp::onTimer() {
+    updateOfflineProgress();
+
     if (suspended) {
         return true;
     }
@@ -634,6 +722,11 @@ bool MapApp::onTimer() {
         map->centerOnPlane();
     }
 
+    if (prefetcher && !locs.empty()) {
+        prefetcher->setRoute(api().getActiveRoute());
+        prefetcher->update(locs[0]);
+    }
+
     map->doWork();
 
     return true;
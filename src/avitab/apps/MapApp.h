@@ -20,6 +20,7 @@
 
 #include <memory>
 #include <vector>
+#include <functional>
 #include "App.h"
 #include "src/avitab/apps/components/FileChooser.h"
 #include "src/gui_toolkit/widgets/PixMap.h"
@@ -34,8 +35,10 @@
 #include "src/gui_toolkit/Timer.h"
 #include "src/libimg/stitcher/Stitcher.h"
 #include "src/libimg/stitcher/TileSource.h"
+#include "src/libimg/stitcher/TileSeeder.h"
 #include "src/libimg/Image.h"
 #include "src/maps/OverlayedMap.h"
+#include "src/maps/TilePrefetcher.h"
 
 namespace avitab {
 
@@ -58,18 +61,31 @@ private:
         NAVIGRAPH_LOW,
     };
 
+    using SourceFactory = std::function<std::shared_ptr<img::TileSource>()>;
+
+    static constexpr const int OFFLINE_EXTRA_ZOOM_LEVELS = 2;
+    static constexpr const size_t MAX_OFFLINE_TILES = 20000;
+
     std::shared_ptr<maps::OverlayConfig> overlayConf;
     std::unique_ptr<FileChooser> fileChooser;
     std::shared_ptr<img::TileSource> tileSource;
     std::shared_ptr<img::Image> mapImage;
     std::shared_ptr<img::Stitcher> mapStitcher;
     std::shared_ptr<maps::OverlayedMap> map;
+    std::shared_ptr<maps::TilePrefetcher> prefetcher;
+
+    // creates another instance of the current source so that storing tiles doesn't interfere with the map
+    SourceFactory offlineSourceFactory;
+    std::unique_ptr<img::TileSeeder> seeder;
+    bool seederReported = true;
 
     std::shared_ptr<Window> window;
     std::shared_ptr<PixMap> mapWidget;
     std::shared_ptr<Button> trackButton;
     std::shared_ptr<Container> settingsContainer, chooserContainer, overlaysContainer;
     std::shared_ptr<Button> openTopoButton, mercatorButton, xplaneButton, geoTiffButton, epsgButton, naviLowButton, naviHighButton;
+    std::shared_ptr<Button> offlineButton;
+    std::shared_ptr<Label> offlineLabel;
     std::shared_ptr<Label> overlayLabel;
     std::shared_ptr<Checkbox> myAircraftCheckbox, otherAircraftCheckbox;
     std::shared_ptr<Checkbox> airportCheckbox, heliseaportCheckbox, airstripCheckbox;
@@ -92,7 +108,7 @@ private:
     void createSettingsLayout();
     void showOverlaySettings();
     void setMapSource(MapSource style);
-    void setTileSource(std::shared_ptr<img::TileSource> source);
+    void setTileSource(std::shared_ptr<img::TileSource> source, SourceFactory offlineFactory = nullptr);
     void selectGeoTIFF();
     void selectMercator();
     void selectEPSG();
@@ -108,6 +124,8 @@ private:
     void onPlusButton();
     void onMinusButton();
     void onTrackButton();
+    void onOfflineButton();
+    void updateOfflineProgress();
     void startCalibration();
     double getCoordinate(const std::string &str);
     void processCalibrationPoint(int step);
@@ -68,6 +68,9 @@ void RouteApp::showDeparturePage() {
 }
 
 void RouteApp::onDepartureEntered(const std::string& departure) {
+    // a new search stops the map from prefetching along the old route
+    api().setActiveRoute(nullptr);
+
     auto navWorld = api().getNavWorld();
     if (!navWorld) {
         showError("No navigation data available");
@@ -122,12 +125,17 @@ void RouteApp::onArrivalEntered(const std::string& arrival) {
 
     arrivalAirport = ap;
 
-    route = std::make_shared<xdata::Route>(departureAirport, arrivalAirport);
+    // the graph only contains the procedures of airports that were loaded before
+    departureAirport->loadProcedures();
+    arrivalAirport->loadProcedures();
+    route = std::make_shared<xdata::Route>(navWorld->getNavGraph(), departureAirport, arrivalAirport);
     route->setAirwayLevel(airwayLevel);
     try {
         route->find();
+        api().setActiveRoute(route);
         showRoute();
     } catch (const std::exception &e) {
+        api().setActiveRoute(nullptr);
         std::string error = std::string("Couldn't find a preliminary route, error: ") + e.what();
         showError(error);
     }
@@ -24,6 +24,7 @@ namespace avitab {
 
 void Environment::loadNavWorldInBackground() {
     getNavData()->discoverSceneries();
+    getNavData()->setSnapshotPath(getProgramPath() + "/navdata.snapshot");
     navWorldFuture = std::async(std::launch::async, &Environment::loadNavWorldAsync, this);
 }
 
@@ -48,6 +49,50 @@ std::shared_ptr<Settings> Environment::getSettings() {
     return settings;
 }
 
+void Environment::loadMagneticModelInBackground() {
+    std::string cofPath = getProgramPath() + "/WMM.COF";
+    magneticModelFuture = std::async(std::launch::async, &Environment::loadMagneticModelAsync, cofPath);
+}
+
+std::shared_ptr<MagneticModel> Environment::loadMagneticModelAsync(const std::string &cofUtf8Path) {
+    crash::ThreadCookie crashCookie;
+
+    try {
+        auto model = std::make_shared<MagneticModel>(cofUtf8Path);
+        model->buildGrid(MagneticModel::getCurrentDecimalYear());
+        return model;
+    } catch (const std::exception &e) {
+        logger::info("No local magnetic model: %s", e.what());
+        return nullptr;
+    }
+}
+
+std::shared_ptr<MagneticModel> Environment::getMagneticModel() const {
+    if (!magneticModelFuture.valid()) {
+        // loading not requested
+        return nullptr;
+    }
+
+    // the grid takes a moment to build, callers fall back until it's done
+    auto state = magneticModelFuture.wait_for(std::chrono::seconds(0));
+    if (state != std::future_status::ready) {
+        return nullptr;
+    }
+    return magneticModelFuture.get();
+}
+
+bool Environment::hasMagneticModel() const {
+    return getMagneticModel() != nullptr;
+}
+
+double Environment::getMagneticVariation(double lat, double lon) {
+    auto model = getMagneticModel();
+    if (!model) {
+        return 0;
+    }
+    return model->getDeclination(lat, lon);
+}
+
 std::shared_ptr<xdata::World> Environment::loadNavWorldAsync() {
     crash::ThreadCookie crashCookie;
 
@@ -60,6 +105,9 @@ std::shared_ptr<xdata::World> Environment::loadNavWorldAsync() {
         throw e;
     }
     logger::info("Nav data ready");
+
+    Location aircraft = getAircraftLocation(0);
+    data->warmUpProcedures(xdata::Location(aircraft.latitude, aircraft.longitude));
     return data->getWorld();
 }
 
@@ -131,6 +179,13 @@ void Environment::enableAndPowerPanel() {
 void Environment::setIsInMenu(bool menu) {
 }
 
+void Environment::subscribeData(const std::string& dataRef) {
+}
+
+EnvData Environment::getSubscribedData(const std::string& dataRef) {
+    throw std::runtime_error("Data not available: " + dataRef);
+}
+
 void Environment::onAircraftReload() {
 
 }
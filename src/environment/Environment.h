@@ -30,6 +30,7 @@
 #include "EnvData.h"
 #include "Config.h"
 #include "Settings.h"
+#include "MagneticModel.h"
 
 namespace avitab {
 
@@ -58,6 +59,7 @@ public:
     std::shared_ptr<Config> getConfig();
     void loadSettings();
     std::shared_ptr<Settings> getSettings();
+    void loadMagneticModelInBackground();
     void loadNavWorldInBackground();
     bool isNavWorldReady();
     virtual void onAircraftReload();
@@ -76,7 +78,7 @@ public:
     virtual std::string getSettingsDir() = 0;
     virtual std::string getEarthTexturePath() = 0;
     virtual void runInEnvironment(EnvironmentCallback cb) = 0;
-    virtual double getMagneticVariation(double lat, double lon) = 0;
+    virtual double getMagneticVariation(double lat, double lon);
     std::shared_ptr<xdata::World> getNavWorld();
     virtual std::string getAirplanePath() = 0;
     void cancelNavWorldLoading();
@@ -88,6 +90,11 @@ public:
     virtual Location getAircraftLocation(AircraftID id) = 0;
     virtual float getLastFrameTime() = 0;
 
+    // Subscribed datarefs are read by the environment once per frame,
+    // getSubscribedData returns their last values without waiting for the next frame
+    virtual void subscribeData(const std::string &dataRef);
+    virtual EnvData getSubscribedData(const std::string &dataRef);
+
     virtual ~Environment() = default;
 protected:
     /**
@@ -99,10 +106,12 @@ protected:
     void runEnvironmentCallbacks();
     virtual std::shared_ptr<xdata::XData> getNavData() = 0;
     virtual void sendUserFixesFilenameToXData(std::string filename) = 0;
+    bool hasMagneticModel() const;
 
 private:
     std::shared_ptr<Config> config;
     std::shared_ptr<Settings> settings;
+    std::shared_future<std::shared_ptr<MagneticModel>> magneticModelFuture;
     std::mutex envMutex;
     std::vector<EnvironmentCallback> envCallbacks;
     std::shared_future<std::shared_ptr<xdata::World>> navWorldFuture;
@@ -112,6 +121,8 @@ private:
     bool stopped = false;
 
     std::shared_ptr<xdata::World> loadNavWorldAsync();
+    static std::shared_ptr<MagneticModel> loadMagneticModelAsync(const std::string &cofUtf8Path);
+    std::shared_ptr<MagneticModel> getMagneticModel() const;
 };
 
 }
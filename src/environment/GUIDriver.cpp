@@ -19,6 +19,7 @@
 #include "GUIDriver.h"
 #include "src/Logger.h"
 #include <cstring>
+#include <algorithm>
 
 namespace avitab {
 
@@ -28,16 +29,34 @@ void GUIDriver::init(int width, int height) {
     bufferWidth = width;
     bufferHeight = height;
     buffer.resize(width * height);
+    addDirtyRect({0, 0, width - 1, height - 1});
 }
 
 void GUIDriver::setResizeCallback(ResizeCallback cb) {
     onResize = cb;
 }
 
+void GUIDriver::setWakeCallback(WakeCallback cb) {
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    onWake = cb;
+}
+
+void GUIDriver::wakeUp() {
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    if (onWake) {
+        onWake();
+    }
+}
+
+bool GUIDriver::isVisible() {
+    return true;
+}
+
 void GUIDriver::resize(int newWidth, int newHeight) {
     bufferWidth = newWidth;
     bufferHeight = newHeight;
     buffer.resize(bufferWidth * bufferHeight);
+    addDirtyRect({0, 0, newWidth - 1, newHeight - 1});
     if (onResize) {
         onResize(newWidth, newHeight);
     }
@@ -63,6 +82,57 @@ void GUIDriver::blit(int32_t x1, int32_t y1, int32_t x2, int32_t y2, const uint3
                w * sizeof(uint32_t));
         data += w;
     }
+
+    addDirtyRect({std::max(x1, 0), std::max(y1, 0), std::min(x2, bufferWidth - 1), std::min(y2, bufferHeight - 1)});
+}
+
+void GUIDriver::addDirtyRect(DirtyRect rect) {
+    std::lock_guard<std::mutex> lock(dirtyMutex);
+
+    // merge with all rects that overlap or touch the new one until none is left
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (auto it = dirtyRects.begin(); it != dirtyRects.end(); ++it) {
+            if (it->x1 <= rect.x2 + 1 && rect.x1 <= it->x2 + 1 && it->y1 <= rect.y2 + 1 && rect.y1 <= it->y2 + 1) {
+                rect.x1 = std::min(rect.x1, it->x1);
+                rect.y1 = std::min(rect.y1, it->y1);
+                rect.x2 = std::max(rect.x2, it->x2);
+                rect.y2 = std::max(rect.y2, it->y2);
+                dirtyRects.erase(it);
+                merged = true;
+                break;
+            }
+        }
+    }
+    dirtyRects.push_back(rect);
+
+    if (dirtyRects.size() > MAX_DIRTY_RECTS) {
+        DirtyRect bounds = dirtyRects.front();
+        for (auto &r: dirtyRects) {
+            bounds.x1 = std::min(bounds.x1, r.x1);
+            bounds.y1 = std::min(bounds.y1, r.y1);
+            bounds.x2 = std::max(bounds.x2, r.x2);
+            bounds.y2 = std::max(bounds.y2, r.y2);
+        }
+        dirtyRects.clear();
+        dirtyRects.push_back(bounds);
+    }
+}
+
+std::vector<GUIDriver::DirtyRect> GUIDriver::takeDirtyRects() {
+    std::vector<DirtyRect> res;
+    std::lock_guard<std::mutex> lock(dirtyMutex);
+    res.swap(dirtyRects);
+
+    // the buffer might have shrunk since the rects were added
+    int w = bufferWidth, h = bufferHeight;
+    res.erase(std::remove_if(res.begin(), res.end(), [w, h] (DirtyRect &r) {
+        r.x2 = std::min(r.x2, w - 1);
+        r.y2 = std::min(r.y2, h - 1);
+        return r.x1 > r.x2 || r.y1 > r.y2;
+    }), res.end());
+    return res;
 }
 
 int GUIDriver::width() {
@@ -89,10 +159,14 @@ bool GUIDriver::wantsKeyInput() {
 }
 
 void GUIDriver::pushKeyInput(uint32_t c) {
-    std::lock_guard<std::mutex> lock(keyMutex);
-    if (enableKeyInput) {
+    {
+        std::lock_guard<std::mutex> lock(keyMutex);
+        if (!enableKeyInput) {
+            return;
+        }
         keyInput.push(c);
     }
+    wakeUp();
 }
 
 uint32_t GUIDriver::popKeyPress() {
@@ -31,11 +31,23 @@ namespace avitab {
 class GUIDriver {
 public:
     using ResizeCallback = std::function<void(int, int)>;
+    using WakeCallback = std::function<void()>;
+
+    // Inclusive pixel coordinates like the LVGL flush areas
+    struct DirtyRect {
+        int x1, y1, x2, y2;
+    };
 
     virtual void init(int width, int height);
 
     void setResizeCallback(ResizeCallback cb);
 
+    // Called for input so that the GUI thread doesn't need to poll
+    void setWakeCallback(WakeCallback cb);
+
+    // The GUI thread stops rendering while nothing can be seen
+    virtual bool isVisible();
+
     virtual void createWindow(const std::string &title) = 0;
     virtual bool hasWindow() = 0;
     virtual void killWindow() = 0;
@@ -63,13 +75,26 @@ protected:
     int width();
     int height();
     void resize(int newWidth, int newHeight);
+    void wakeUp();
+
+    // The areas changed since the last call, so that drivers only upload those
+    std::vector<DirtyRect> takeDirtyRects();
 private:
+    // More rects are merged into their bounding box
+    static constexpr const size_t MAX_DIRTY_RECTS = 16;
+
     ResizeCallback onResize;
+    std::mutex wakeMutex;
+    WakeCallback onWake;
     std::mutex keyMutex;
     bool enableKeyInput = false;
     std::atomic_int bufferWidth{0}, bufferHeight{0};
     std::vector<uint32_t> buffer;
     std::queue<uint32_t> keyInput;
+    std::mutex dirtyMutex;
+    std::vector<DirtyRect> dirtyRects;
+
+    void addDirtyRect(DirtyRect rect);
 };
 
 }
@@ -0,0 +1,242 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cmath>
+#include <ctime>
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include "MagneticModel.h"
+#include "src/platform/Platform.h"
+#include "src/Logger.h"
+
+namespace avitab {
+
+namespace {
+    constexpr const double WGS84_A = 6378.137; // km
+    constexpr const double WGS84_F = 1 / 298.257223563;
+    constexpr const double REFERENCE_RADIUS = 6371.2; // km
+    constexpr const double DEG_TO_RAD = M_PI / 180.0;
+}
+
+MagneticModel::MagneticModel(const std::string& cofUtf8Path) {
+    loadCoefficients(cofUtf8Path);
+    logger::info("Loaded magnetic model %s, epoch %.1f", modelName.c_str(), epoch);
+}
+
+void MagneticModel::loadCoefficients(const std::string& cofUtf8Path) {
+    fs::ifstream in(fs::u8path(cofUtf8Path));
+    if (!in) {
+        throw std::runtime_error("Couldn't open " + cofUtf8Path);
+    }
+
+    std::string line;
+    if (!std::getline(in, line)) {
+        throw std::runtime_error("Empty magnetic model file");
+    }
+
+    std::istringstream header(line);
+    if (!(header >> epoch >> modelName)) {
+        throw std::runtime_error("Invalid magnetic model header");
+    }
+
+    struct Coefficient {
+        int n, m;
+        double g, h, gDot, hDot;
+    };
+    std::vector<Coefficient> coefficients;
+
+    while (std::getline(in, line)) {
+        if (line.compare(0, 4, "9999") == 0) {
+            break;
+        }
+
+        std::istringstream fields(line);
+        Coefficient c;
+        if (!(fields >> c.n >> c.m >> c.g >> c.h >> c.gDot >> c.hDot)) {
+            continue;
+        }
+        if (c.n < 1 || c.m < 0 || c.m > c.n) {
+            throw std::runtime_error("Invalid magnetic model coefficient: " + line);
+        }
+        coefficients.push_back(c);
+        maxDegree = std::max(maxDegree, c.n);
+    }
+
+    if (coefficients.empty()) {
+        throw std::runtime_error("No coefficients in magnetic model file");
+    }
+
+    size_t count = (maxDegree + 1) * (maxDegree + 1);
+    g.assign(count, 0);
+    h.assign(count, 0);
+    gDot.assign(count, 0);
+    hDot.assign(count, 0);
+    for (auto &c: coefficients) {
+        size_t i = index(c.n, c.m);
+        g[i] = c.g;
+        h[i] = c.h;
+        gDot[i] = c.gDot;
+        hDot[i] = c.hDot;
+    }
+}
+
+size_t MagneticModel::index(int n, int m) const {
+    return n * (maxDegree + 1) + m;
+}
+
+void MagneticModel::buildGrid(double decimalYear) {
+    if (decimalYear < epoch || decimalYear > epoch + 5) {
+        logger::warn("Magnetic model %s is not valid for %.1f", modelName.c_str(), decimalYear);
+    }
+
+    std::vector<float> newGrid(GRID_ROWS * GRID_COLUMNS);
+    for (int row = 0; row < GRID_ROWS; row++) {
+        // the declination is undefined at the poles
+        double lat = std::max(-89.9, std::min(89.9, -90 + row * GRID_STEP));
+        for (int col = 0; col < GRID_COLUMNS; col++) {
+            double lon = -180 + col * GRID_STEP;
+            newGrid[row * GRID_COLUMNS + col] = computeDeclination(lat, lon, decimalYear);
+        }
+    }
+    grid = std::move(newGrid);
+}
+
+double MagneticModel::getDeclination(double lat, double lon) const {
+    if (grid.empty()) {
+        throw std::runtime_error("Magnetic model grid not built");
+    }
+
+    lat = std::max(-90.0, std::min(90.0, lat));
+    lon = std::fmod(lon + 180, 360);
+    if (lon < 0) {
+        lon += 360;
+    }
+
+    double y = (lat + 90) / GRID_STEP;
+    double x = lon / GRID_STEP;
+    int row = std::min((int) y, GRID_ROWS - 2);
+    int col = std::min((int) x, GRID_COLUMNS - 2);
+    double fy = y - row;
+    double fx = x - col;
+
+    // interpolate the differences so that jumps near +-180 degrees don't average out
+    double d00 = grid[row * GRID_COLUMNS + col];
+    auto rel = [d00] (double d) {
+        double diff = d - d00;
+        if (diff > 180) {
+            diff -= 360;
+        } else if (diff < -180) {
+            diff += 360;
+        }
+        return diff;
+    };
+    double d10 = rel(grid[row * GRID_COLUMNS + col + 1]);
+    double d01 = rel(grid[(row + 1) * GRID_COLUMNS + col]);
+    double d11 = rel(grid[(row + 1) * GRID_COLUMNS + col + 1]);
+
+    double res = d00 + (1 - fy) * fx * d10 + fy * (1 - fx) * d01 + fy * fx * d11;
+    if (res > 180) {
+        res -= 360;
+    } else if (res < -180) {
+        res += 360;
+    }
+    return res;
+}
+
+double MagneticModel::computeDeclination(double lat, double lon, double decimalYear) const {
+    double dt = decimalYear - epoch;
+
+    // geodetic to geocentric at sea level
+    double phi = lat * DEG_TO_RAD;
+    double lambda = lon * DEG_TO_RAD;
+    double e2 = WGS84_F * (2 - WGS84_F);
+    double sinPhi = std::sin(phi);
+    double rc = WGS84_A / std::sqrt(1 - e2 * sinPhi * sinPhi);
+    double p = rc * std::cos(phi);
+    double z = rc * (1 - e2) * sinPhi;
+    double r = std::sqrt(p * p + z * z);
+    double phiC = std::asin(z / r);
+
+    double cosTheta = std::sin(phiC);
+    double sinTheta = std::cos(phiC);
+
+    // Schmidt semi-normalized associated Legendre functions and their derivatives by theta
+    size_t count = (maxDegree + 1) * (maxDegree + 1);
+    std::vector<double> P(count, 0), dP(count, 0);
+    P[index(0, 0)] = 1;
+    dP[index(0, 0)] = 0;
+    for (int n = 1; n <= maxDegree; n++) {
+        if (n == 1) {
+            P[index(1, 1)] = sinTheta;
+            dP[index(1, 1)] = cosTheta;
+        } else {
+            double k = std::sqrt((2.0 * n - 1) / (2.0 * n));
+            P[index(n, n)] = k * sinTheta * P[index(n - 1, n - 1)];
+            dP[index(n, n)] = k * (cosTheta * P[index(n - 1, n - 1)] + sinTheta * dP[index(n - 1, n - 1)]);
+        }
+
+        for (int m = 0; m < n; m++) {
+            double k = std::sqrt(double(n * n - m * m));
+            double prev2 = 0, dPrev2 = 0, k2 = 0;
+            if (m <= n - 2) {
+                k2 = std::sqrt(double((n - 1) * (n - 1) - m * m));
+                prev2 = P[index(n - 2, m)];
+                dPrev2 = dP[index(n - 2, m)];
+            }
+            double prev = P[index(n - 1, m)];
+            double dPrev = dP[index(n - 1, m)];
+            P[index(n, m)] = ((2 * n - 1) * cosTheta * prev - k2 * prev2) / k;
+            dP[index(n, m)] = ((2 * n - 1) * (cosTheta * dPrev - sinTheta * prev) - k2 * dPrev2) / k;
+        }
+    }
+
+    double north = 0, east = 0, down = 0;
+    double ratio = REFERENCE_RADIUS / r;
+    double ratioPow = ratio * ratio;
+    for (int n = 1; n <= maxDegree; n++) {
+        ratioPow *= ratio;
+        for (int m = 0; m <= n; m++) {
+            size_t i = index(n, m);
+            double gnm = g[i] + dt * gDot[i];
+            double hnm = h[i] + dt * hDot[i];
+            double cosML = std::cos(m * lambda);
+            double sinML = std::sin(m * lambda);
+            double gh = gnm * cosML + hnm * sinML;
+
+            north += ratioPow * gh * dP[i];
+            east += ratioPow * m * (gnm * sinML - hnm * cosML) * P[i];
+            down -= ratioPow * (n + 1) * gh * P[i];
+        }
+    }
+    east /= sinTheta;
+
+    // rotate from geocentric back to geodetic
+    double psi = phiC - phi;
+    double northGeodetic = north * std::cos(psi) - down * std::sin(psi);
+
+    return std::atan2(east, northGeodetic) / DEG_TO_RAD;
+}
+
+double MagneticModel::getCurrentDecimalYear() {
+    std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::tm utc = *std::gmtime(&now);
+    return 1900 + utc.tm_year + utc.tm_yday / 365.25;
+}
+
+} /* namespace avitab */
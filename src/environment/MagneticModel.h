@@ -0,0 +1,66 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SRC_ENVIRONMENT_MAGNETICMODEL_H_
+#define SRC_ENVIRONMENT_MAGNETICMODEL_H_
+
+#include <string>
+#include <vector>
+
+namespace avitab {
+
+/*
+ * Evaluates the World Magnetic Model from a NOAA WMM.COF coefficient file
+ * and keeps a precomputed declination grid so that lookups are cheap and
+ * can be done from any thread.
+ */
+class MagneticModel {
+public:
+    // Throws if the coefficient file can't be parsed
+    MagneticModel(const std::string &cofUtf8Path);
+
+    // Fills the lookup grid for the given date, e.g. 2024.5
+    void buildGrid(double decimalYear);
+
+    // Interpolated from the grid, in degrees, positive is east
+    double getDeclination(double lat, double lon) const;
+
+    // Full model evaluation at sea level, in degrees, positive is east
+    double computeDeclination(double lat, double lon, double decimalYear) const;
+
+    static double getCurrentDecimalYear();
+
+private:
+    static constexpr const double GRID_STEP = 1; // degrees
+    static constexpr const int GRID_ROWS = 181;
+    static constexpr const int GRID_COLUMNS = 361;
+
+    std::string modelName;
+    double epoch = 0;
+    int maxDegree = 0;
+
+    // indexed by n * (maxDegree + 1) + m
+    std::vector<double> g, h, gDot, hDot;
+    std::vector<float> grid;
+
+    void loadCoefficients(const std::string &cofUtf8Path);
+    size_t index(int n, int m) const;
+};
+
+} /* namespace avitab */
+
+#endif /* SRC_ENVIRONMENT_MAGNETICMODEL_H_ */
@@ -95,7 +95,7 @@ void Settings::setSetting(const std::string &id, const T value) {
 
 void Settings::init() {
     // full init not required, just defaults that aren't zero/false/empty
-    *database = { { "general", { { "prefs_version", 1 }, { "show_fps", true } } }, { "overlay", { { "my_aircraft", true } } } };
+    *database = { { "general", { { "prefs_version", 1 }, { "show_fps", true }, { "gui_max_fps", 30 } } }, { "overlay", { { "my_aircraft", true } } } };
 }
 
 void Settings::load() {
@@ -63,11 +63,13 @@ void GlfwGUIDriver::createWindow(const std::string& title) {
         glfwGetWindowSize(wnd, &w, &h);
         us->mouseX = x / w * us->width();
         us->mouseY = y / h * us->height();
+        us->wakeUp();
     });
     glfwSetMouseButtonCallback(window, [] (GLFWwindow *wnd, int button, int action, int flags) {
         GlfwGUIDriver *us = (GlfwGUIDriver *) glfwGetWindowUserPointer(wnd);
         if (button == GLFW_MOUSE_BUTTON_LEFT) {
             us->mousePressed = (action == GLFW_PRESS);
+            us->wakeUp();
         }
     });
     glfwSetScrollCallback(window, [] (GLFWwindow *wnd, double x, double y) {
@@ -79,6 +81,7 @@ void GlfwGUIDriver::createWindow(const std::string& title) {
         } else {
             us->wheelDir = 0;
         }
+        us->wakeUp();
     });
     glfwSetKeyCallback(window, [] (GLFWwindow *wnd, int key, int scanCode, int action, int mods) {
         GlfwGUIDriver *us = (GlfwGUIDriver *) glfwGetWindowUserPointer(wnd);
@@ -152,14 +155,6 @@ void GlfwGUIDriver::onQuit() {
     }
 }
 
-void GlfwGUIDriver::blit(int32_t x1, int32_t y1, int32_t x2, int32_t y2, const uint32_t* newData) {
-    // called from LVGL thread
-    GUIDriver::blit(x1, y1, x2, y2, newData);
-
-    std::lock_guard<std::mutex> lock(driverMutex);
-    needsRedraw = true;
-}
-
 void GlfwGUIDriver::render() {
     auto startAt = std::chrono::steady_clock::now();
 
@@ -177,15 +172,16 @@ void GlfwGUIDriver::render() {
     glBindTexture(GL_TEXTURE_2D, textureId);
     glEnable(GL_TEXTURE_2D);
 
-    {
-        std::lock_guard<std::mutex> lock(driverMutex);
-        if (needsRedraw) {
+    auto rects = takeDirtyRects();
+    if (!rects.empty()) {
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, width());
+        for (auto &r: rects) {
             glTexSubImage2D(GL_TEXTURE_2D, 0,
-                    0, 0,
-                    width(), height(),
-                    GL_BGRA, GL_UNSIGNED_BYTE, data());
-            needsRedraw = false;
+                    r.x1, r.y1,
+                    r.x2 - r.x1 + 1, r.y2 - r.y1 + 1,
+                    GL_BGRA, GL_UNSIGNED_BYTE, data() + r.y1 * width() + r.x1);
         }
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
     }
 
     glColor3f(brightness, brightness, brightness);
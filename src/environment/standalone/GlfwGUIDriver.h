@@ -38,7 +38,6 @@ public:
     bool handleEvents();
     uint32_t getLastDrawTime();
 
-    void blit(int32_t x1, int32_t y1, int32_t x2, int32_t y2, const uint32_t *newData) override;
     void readPointerState(int &x, int &y, bool &pressed) override;
     int getWheelDirection() override;
     ~GlfwGUIDriver();
@@ -50,7 +49,6 @@ private:
     GLuint textureId{};
     std::atomic<uint32_t> lastDrawTime {0};
     float brightness = 1;
-    bool needsRedraw = false;
 
     std::atomic_int mouseX {0}, mouseY {0}, wheelDir {0};
     bool mousePressed {false};
@@ -109,10 +109,6 @@ void StandAloneEnvironment::sendUserFixesFilenameToXData(std::string filename) {
     xplaneData->setUserFixesFilename(filename);
 }
 
-double StandAloneEnvironment::getMagneticVariation(double lat, double lon) {
-    return 0;
-}
-
 void StandAloneEnvironment::runInEnvironment(EnvironmentCallback cb) {
     registerEnvironmentCallback(cb);
 }
@@ -48,7 +48,6 @@ public:
     std::string getEarthTexturePath() override;
     void runInEnvironment(EnvironmentCallback cb) override;
     std::shared_ptr<xdata::XData> getNavData() override;
-    double getMagneticVariation(double lat, double lon) override;
     void reloadMetar() override;
     void loadUserFixes(std::string filename) override;
     AircraftID getActiveAircraftCount() override;
@@ -19,7 +19,6 @@
 #include <XPLM/XPLMPlanes.h>
 #include <XPLM/XPLMScenery.h>
 #include <stdexcept>
-#include <chrono>
 #include "XPlaneEnvironment.h"
 #include "XPlaneGUIDriver.h"
 #include "src/Logger.h"
@@ -40,6 +39,7 @@ XPlaneEnvironment::XPlaneEnvironment() {
     xplaneData = std::make_shared<xdata::XData>(xplaneRootPath);
 
     updatePlaneCount();
+    dataSnapshot = std::make_shared<const DataSnapshot>();
 
     panelEnabled = std::make_shared<int>(0);
     panelPowered = std::make_shared<int>(0);
@@ -271,9 +271,18 @@ void XPlaneEnvironment::runInEnvironment(EnvironmentCallback cb) {
 }
 
 float XPlaneEnvironment::onFlightLoop(float elapsedSinceLastCall, float elapseSinceLastLoop, int count) {
-    std::vector<Location> activeAircraftLocations;
-
     updatePlaneCount();
+    publishDataSnapshot();
+
+    runEnvironmentCallbacks();
+    return -1;
+}
+
+void XPlaneEnvironment::publishDataSnapshot() {
+    // gets called by the environment thread
+    auto snapshot = std::make_shared<DataSnapshot>();
+    snapshot->aircraftCount = otherAircraftCount + 1;
+
     for (AircraftID i = 0; i <= otherAircraftCount; ++i) {
         try {
             Location loc;
@@ -281,73 +290,80 @@ float XPlaneEnvironment::onFlightLoop(float elapsedSinceLastCall, float elapseSi
             loc.longitude = dataCache.getLocationData(i, 1).doubleValue;
             loc.elevation = dataCache.getLocationData(i, 2).doubleValue;
             loc.heading = dataCache.getLocationData(i, 3).floatValue;
-            activeAircraftLocations.push_back(loc);
+            snapshot->aircraftLocations.push_back(loc);
         } catch (const std::exception &e) {
             // silently ignore to avoid flooding the log
             // can fail with TCAS override, more than 19 AI aircraft
         }
     }
 
-    {
-        std::lock_guard<std::mutex> lock(stateMutex);
-        aircraftLocations = activeAircraftLocations;
+    snapshot->frameTime = dataCache.getData("sim/operation/misc/frame_rate_period").floatValue;
+
+    for (auto it = subscribedRefs.begin(); it != subscribedRefs.end(); ) {
+        try {
+            snapshot->subscribedData[*it] = dataCache.getData(*it);
+            ++it;
+        } catch (const std::exception &e) {
+            logger::warn("Removing subscription of %s: %s", it->c_str(), e.what());
+            it = subscribedRefs.erase(it);
+        }
     }
 
-    lastDrawTime = dataCache.getData("sim/operation/misc/frame_rate_period").floatValue;
+    std::atomic_store(&dataSnapshot, std::shared_ptr<const DataSnapshot>(snapshot));
+}
 
-    runEnvironmentCallbacks();
-    return -1;
+std::shared_ptr<const XPlaneEnvironment::DataSnapshot> XPlaneEnvironment::getDataSnapshot() const {
+    return std::atomic_load(&dataSnapshot);
 }
 
 AircraftID XPlaneEnvironment::getActiveAircraftCount() {
-    std::lock_guard<std::mutex> lock(stateMutex);
-    return (otherAircraftCount + 1);
+    return getDataSnapshot()->aircraftCount;
 }
 
 Location XPlaneEnvironment::getAircraftLocation(AircraftID id) {
-    std::lock_guard<std::mutex> lock(stateMutex);
-    if (id < aircraftLocations.size()) {
-        return aircraftLocations[id];
+    auto snapshot = getDataSnapshot();
+    if (id < snapshot->aircraftLocations.size()) {
+        return snapshot->aircraftLocations[id];
     } else {
         return nullLocation;
     }
 }
 
 float XPlaneEnvironment::getLastFrameTime() {
-    return lastDrawTime;
+    return getDataSnapshot()->frameTime;
 }
 
-EnvData XPlaneEnvironment::getData(const std::string& dataRef) {
-    std::promise<EnvData> dataPromise;
-    auto futureData = dataPromise.get_future();
-
-    runInEnvironment([&dataPromise, &dataRef, this] () {
-        try {
-            dataPromise.set_value(dataCache.getData(dataRef));
-        } catch (...) {
-            // transfer exceptions across the threads
-            dataPromise.set_exception(std::current_exception());
-        }
+void XPlaneEnvironment::subscribeData(const std::string& dataRef) {
+    // the value is available after the next flight loop
+    runInEnvironment([this, dataRef] () {
+        subscribedRefs.insert(dataRef);
     });
+}
 
-    return futureData.get();
+EnvData XPlaneEnvironment::getSubscribedData(const std::string& dataRef) {
+    auto snapshot = getDataSnapshot();
+    auto it = snapshot->subscribedData.find(dataRef);
+    if (it == snapshot->subscribedData.end()) {
+        throw std::runtime_error("Data not available: " + dataRef);
+    }
+    return it->second;
 }
 
 double XPlaneEnvironment::getMagneticVariation(double lat, double lon) {
+    if (hasMagneticModel()) {
+        return Environment::getMagneticVariation(lat, lon);
+    }
+
+    // without a local model, X-Plane must be asked in the next flight loop
     std::promise<double> dataPromise;
     auto futureData = dataPromise.get_future();
 
-    auto startAt = std::chrono::steady_clock::now();
     runInEnvironment([&dataPromise, &lat, &lon] () {
         double variation = XPLMGetMagneticVariation(lat, lon);
         dataPromise.set_value(variation);
     });
 
-    auto res = futureData.get();
-    auto duration = std::chrono::steady_clock::now() - startAt;
-    logger::verbose("Time to get magnetic variation: %d millis",
-            std::chrono::duration_cast<std::chrono::milliseconds>(duration).count());
-    return res;
+    return futureData.get();
 }
 
 std::shared_ptr<xdata::XData> XPlaneEnvironment::getNavData() {
@@ -25,6 +25,7 @@
 #include <vector>
 #include <atomic>
 #include <map>
+#include <set>
 #include <thread>
 #include "src/gui_toolkit/LVGLToolkit.h"
 #include "src/environment/Environment.h"
@@ -62,6 +63,8 @@ public:
     AircraftID getActiveAircraftCount() override;
     Location getAircraftLocation(AircraftID id) override;
     float getLastFrameTime() override;
+    void subscribeData(const std::string &dataRef) override;
+    EnvData getSubscribedData(const std::string &dataRef) override;
 
     ~XPlaneEnvironment();
 private:
@@ -71,15 +74,27 @@ private:
         void *refCon;
     };
 
+    // Published once per flight loop and never modified afterwards
+    struct DataSnapshot {
+        AircraftID aircraftCount = 1;
+        std::vector<Location> aircraftLocations;
+        float frameTime = 0;
+        std::map<std::string, EnvData> subscribedData;
+    };
+
     // Cached data
     DataCache dataCache;
     std::string pluginPath, xplanePrefsDir, xplaneRootPath;
     std::shared_ptr<xdata::XData> xplaneData;
-    std::vector<Location> aircraftLocations;
     Location nullLocation { 0, 0, 0, 0 };
-    std::atomic<float> lastDrawTime{};
     std::string aircraftPath;
 
+    // Replaced atomically by the flight loop so that readers never wait for the simulator
+    std::shared_ptr<const DataSnapshot> dataSnapshot;
+
+    // Only used by the environment thread
+    std::set<std::string> subscribedRefs;
+
     // State
     std::mutex stateMutex;
     std::vector<MenuCallback> menuCallbacks;
@@ -98,7 +113,8 @@ private:
     XPLMFlightLoopID createFlightLoop();
     float onFlightLoop(float elapsedSinceLastCall, float elapseSinceLastLoop, int count);
     static int handleCommand(XPLMCommandRef cmd, XPLMCommandPhase phase, void *ref);
-    EnvData getData(const std::string &dataRef);
+    std::shared_ptr<const DataSnapshot> getDataSnapshot() const;
+    void publishDataSnapshot();
     void reloadAircraftPath();
 
     unsigned int otherAircraftCount;
@@ -25,6 +25,7 @@
 #include <GL/glext.h>
 #endif
 #include <stdexcept>
+#include <chrono>
 #include "XPlaneGUIDriver.h"
 #include "src/Logger.h"
 
@@ -286,13 +287,6 @@ void XPlaneGUIDriver::killWindow() {
     }
 }
 
-void XPlaneGUIDriver::blit(int32_t x1, int32_t y1, int32_t x2, int32_t y2, const uint32_t* data) {
-    GUIDriver::blit(x1, y1, x2, y2, data);
-
-    std::lock_guard<std::mutex> lock(drawMutex);
-    needsRedraw = true;
-}
-
 void XPlaneGUIDriver::onDraw() {
     if (!window) {
         logger::warn("No window in onDraw");
@@ -302,6 +296,7 @@ void XPlaneGUIDriver::onDraw() {
     int left, top, right, bottom;
     XPLMGetWindowGeometry(window, &left, &top, &right, &bottom);
 
+    onVisibleDraw();
     XPLMBindTexture2d(textureId, 0);
     redrawTexture();
 
@@ -351,8 +346,10 @@ void XPlaneGUIDriver::onDrawPanel() {
     if (!gotAnyTrigger && mouseDownFromTrigger) {
         mousePressed = false;
         mouseDownFromTrigger = false;
+        wakeUp();
     }
 
+    onVisibleDraw();
     XPLMBindTexture2d(textureId, 0);
     redrawTexture();
 
@@ -362,15 +359,39 @@ void XPlaneGUIDriver::onDrawPanel() {
     renderWindowTexture(left, top, right, bottom);
 }
 
+int64_t XPlaneGUIDriver::getMillis() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+}
+
+void XPlaneGUIDriver::onVisibleDraw() {
+    int64_t now = getMillis();
+    int64_t lastDraw = lastVisibleDraw.exchange(now);
+    if (now - lastDraw > VISIBILITY_TIMEOUT_MS) {
+        // the GUI thread only ticks slowly while hidden, so render the content now
+        wakeUp();
+    }
+}
+
+bool XPlaneGUIDriver::isVisible() {
+    return getMillis() - lastVisibleDraw < VISIBILITY_TIMEOUT_MS;
+}
+
 void XPlaneGUIDriver::redrawTexture() {
-    std::lock_guard<std::mutex> lock(drawMutex);
-    if (needsRedraw) {
+    auto rects = takeDirtyRects();
+    if (rects.empty()) {
+        return;
+    }
+
+    // upload only the changed areas, the rows are taken from the full buffer
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, width());
+    for (auto &r: rects) {
         glTexSubImage2D(GL_TEXTURE_2D, 0,
-                0, 0,
-                width(), height(),
-                GL_BGRA, GL_UNSIGNED_BYTE, data());
-        needsRedraw = false;
+                r.x1, r.y1,
+                r.x2 - r.x1 + 1, r.y2 - r.y1 + 1,
+                GL_BGRA, GL_UNSIGNED_BYTE, data() + r.y1 * width() + r.x1);
     }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 }
 
 void XPlaneGUIDriver::correctRatio(int &left, int &top, int& right, int& bottom, bool center) {
@@ -489,6 +510,7 @@ bool XPlaneGUIDriver::onClick(int x, int y, XPLMMouseStatus status) {
         mouseY = guiY;
     }
 
+    wakeUp();
     return true;
 }
 
@@ -502,6 +524,7 @@ bool XPlaneGUIDriver::onMouseWheel(int x, int y, int wheel, int clicks) {
         mouseX = px;
         mouseY = py;
         mouseWheel = clicks;
+        wakeUp();
         return true;
     }
     return false;
@@ -552,6 +575,8 @@ bool XPlaneGUIDriver::onClickCapture(int x, int y, XPLMMouseStatus status) {
         isInWindow = false;
     }
 
+    wakeUp();
+
     if (isInWindow) {
         mouseX = (tx - left) / (right - left) * width();
         mouseY = (top - ty) / (top - bottom) * height();
@@ -590,6 +615,7 @@ bool XPlaneGUIDriver::onMouseWheelCapture(int x, int y, int wheel, int clicks) {
         mouseX = (guiX - left) / (right - left) * width();
         mouseY = (top - guiY) / (top - bottom) * height();
         mouseWheel = clicks;
+        wakeUp();
         return true;
     }
     return false;
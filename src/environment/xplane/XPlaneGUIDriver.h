@@ -46,9 +46,9 @@ public:
     void hidePanel() override;
 
     void readPointerState(int &x, int &y, bool &pressed) override;
-    void blit(int32_t x1, int32_t y1, int32_t x2, int32_t y2, const uint32_t *data) override;
 
     int getWheelDirection() override;
+    bool isVisible() override;
     void setBrightness(float b) override;
     float getBrightness() override;
 
@@ -66,14 +66,18 @@ private:
     std::atomic_int mouseX {0}, mouseY {0};
     std::atomic_bool mousePressed {false};
     std::atomic_int mouseWheel {0};
-    std::mutex drawMutex;
-    bool needsRedraw = false;
     XPLMDataRef panelLeftRef{}, panelBottomRef{}, panelWidthRef{}, panelHeightRef{};
     int panelLeft = 0, panelBottom = 0, panelWidth = 0, panelHeight = 0;
     std::vector<int> vrTriggerIndices;
     bool mouseDownFromTrigger = false;
     bool hasPanel = false;
 
+    // X-Plane only draws the window and powered panel while they can be seen
+    static constexpr const int VISIBILITY_TIMEOUT_MS = 500;
+    std::atomic<int64_t> lastVisibleDraw { 0 };
+
+    static int64_t getMillis();
+    void onVisibleDraw();
     void onDraw();
     void onDrawPanel();
     void redrawTexture();
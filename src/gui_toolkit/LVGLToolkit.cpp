@@ -37,6 +37,7 @@ LVGLToolkit::LVGLToolkit(std::shared_ptr<GUIDriver> drv):
     driver(drv)
 {
     driver->init(INITIAL_WIDTH, INITIAL_HEIGHT);
+    driver->setWakeCallback([this] () { wakeUp(); });
 
     if (!lvglIsInitialized) {
         // LVGL does not support de-initialization so we can only do this once
@@ -168,11 +169,13 @@ void LVGLToolkit::hidePanel() {
 
 void LVGLToolkit::signalStop() {
     guiActive = false;
+    wakeUp();
 }
 
 void LVGLToolkit::destroyNativeWindow() {
     if (guiThread) {
         guiActive = false;
+        wakeUp();
         guiThread->join();
         guiThread.reset();
         mainScreen.reset();
@@ -198,8 +201,14 @@ float LVGLToolkit::getBrightness() {
     return driver->getBrightness();
 }
 
+void LVGLToolkit::setMaxFrameRate(int fps) {
+    if (fps <= 0) {
+        fps = DEFAULT_MAX_FPS;
+    }
+    frameMillis = std::max(1, 1000 / fps);
+}
+
 void LVGLToolkit::guiLoop() {
-    using namespace std::chrono_literals;
     crash::ThreadCookie crashCookie;
 
     logger::verbose("LVGL thread has id %d", std::this_thread::get_id());
@@ -235,7 +244,7 @@ void LVGLToolkit::guiLoop() {
             logger::error("Exception in GUI: %s", e.what());
         }
 
-        std::this_thread::sleep_for(1ms);
+        waitForWork();
         auto elapsedMillis = platform::getElapsedMillis(startAt);
 
         lv_tick_inc(std::max(elapsedMillis, 1));
@@ -244,6 +253,32 @@ void LVGLToolkit::guiLoop() {
     logger::verbose("LVGL thread destroyed");
 }
 
+void LVGLToolkit::waitForWork() {
+    // gets called unlocked
+    std::unique_lock<std::recursive_mutex> lock(guiMutex);
+    auto hasWork = [this] () {
+        return wakeRequested || !pendingTasks.empty() || !guiActive;
+    };
+
+    if (driver->isVisible()) {
+        // LVGL's animations and refreshes only need to run once per frame
+        wakeCondition.wait_for(lock, std::chrono::milliseconds(frameMillis), hasWork);
+    } else {
+        // nothing can be seen, but the apps' timers must keep running at a low rate,
+        // e.g. the map prefetches tiles while the tablet is closed
+        wakeCondition.wait_for(lock, std::chrono::milliseconds(HIDDEN_TICK_MILLIS), hasWork);
+    }
+    wakeRequested = false;
+}
+
+void LVGLToolkit::wakeUp() {
+    {
+        std::lock_guard<std::recursive_mutex> lock(guiMutex);
+        wakeRequested = true;
+    }
+    wakeCondition.notify_one();
+}
+
 void LVGLToolkit::sendLeftClick(bool down) {
     driver->passLeftClick(down);
 }
@@ -323,6 +358,7 @@ void LVGLToolkit::executeLater(GUITask func) {
     std::lock_guard<std::recursive_mutex> lock(guiMutex);
     if (guiActive) {
         pendingTasks.push_back(func);
+        wakeCondition.notify_one();
     }
 }
 
@@ -330,6 +366,7 @@ LVGLToolkit::~LVGLToolkit() {
     logger::verbose("~LVGLToolkit");
     inputDriver.user_data = nullptr;
     lvDriver.user_data = nullptr;
+    driver->setWakeCallback(nullptr);
     destroyNativeWindow();
 }
 
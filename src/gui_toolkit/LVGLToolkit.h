@@ -23,6 +23,7 @@
 #include <memory>
 #include <functional>
 #include <mutex>
+#include <condition_variable>
 #include <vector>
 #include "src/environment/GUIDriver.h"
 #include "src/gui_toolkit/widgets/Screen.h"
@@ -48,6 +49,9 @@ public:
     float getBrightness();
     void sendLeftClick(bool down);
 
+    // Limits how often LVGL runs while the GUI is visible, 0 for the default
+    void setMaxFrameRate(int fps);
+
     std::shared_ptr<Screen> &screen();
 
     void executeLater(GUITask func);
@@ -56,10 +60,15 @@ public:
 private:
     static const int INITIAL_WIDTH = 800;
     static const int INITIAL_HEIGHT = 480;
+    static const int DEFAULT_MAX_FPS = 30;
+    static const int HIDDEN_TICK_MILLIS = 1000;
 
     MouseWheelCallback onMouseWheel;
     std::recursive_mutex guiMutex;
     std::vector<GUITask> pendingTasks;
+    std::condition_variable_any wakeCondition;
+    bool wakeRequested = false;
+    std::atomic_int frameMillis { 1000 / DEFAULT_MAX_FPS };
     std::shared_ptr<GUIDriver> driver;
     std::unique_ptr<std::thread> guiThread;
     std::atomic_bool guiActive;
@@ -68,6 +77,8 @@ private:
     void initDisplayDriver();
     void initInputDriver();
     void guiLoop();
+    void waitForWork();
+    void wakeUp();
     void handleMouseWheel();
     void handleKeyboard();
 
@@ -17,9 +17,11 @@
  */
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_RESIZE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
 #define STBI_WINDOWS_UTF8
 #include <stb/stb_image.h>
 #include <stb/stb_image_resize.h>
+#include <stb/stb_image_write.h>
 #include <stdexcept>
 #include <cstring>
 #include <cstdlib>
@@ -31,6 +33,7 @@
 #include "src/Logger.h"
 #include "src/platform/Platform.h"
 #include "TTFStamper.h"
+#include "PixelKernels.h"
 
 namespace img {
 
@@ -100,15 +103,7 @@ void Image::loadEncodedData(const std::vector<uint8_t>& encodedImage, bool keepD
 
 void Image::setPixels(uint8_t* data, int srcWidth, int srcHeight) {
     pixels->resize(srcWidth * srcHeight);
-    uint32_t *dstData = pixels->data();
-
-    for (int i = 0; i < srcWidth * srcHeight * 4; i += 4) {
-        uint32_t argb = (data[i + 3] << 24) |
-                        (data[i + 0] << 16) |
-                        (data[i + 1] << 8)  |
-                        data[i + 2];
-        dstData[i / 4] = argb;
-    }
+    convertRGBAToARGB(data, pixels->data(), srcWidth * srcHeight);
     this->width = srcWidth;
     this->height = srcHeight;
 }
@@ -127,6 +122,43 @@ void Image::storeAndClearEncodedData(const std::string& utf8Path) {
     encodedData.reset();
 }
 
+std::vector<uint8_t> Image::takeEncodedData() {
+    std::vector<uint8_t> res;
+    if (encodedData) {
+        res = std::move(*encodedData);
+        encodedData.reset();
+    }
+    return res;
+}
+
+bool Image::hasEncodedData() const {
+    return encodedData != nullptr;
+}
+
+void Image::encodePNG() {
+    std::vector<uint8_t> rgba(width * height * 4);
+    const uint32_t *src = pixels->data();
+    for (int i = 0; i < width * height; i++) {
+        uint32_t argb = src[i];
+        rgba[i * 4 + 0] = (argb >> 16) & 0xFF;
+        rgba[i * 4 + 1] = (argb >> 8) & 0xFF;
+        rgba[i * 4 + 2] = argb & 0xFF;
+        rgba[i * 4 + 3] = (argb >> 24) & 0xFF;
+    }
+
+    auto png = std::make_unique<std::vector<uint8_t>>();
+    auto append = [] (void *context, void *data, int size) {
+        auto out = reinterpret_cast<std::vector<uint8_t> *>(context);
+        auto bytes = reinterpret_cast<const uint8_t *>(data);
+        out->insert(out->end(), bytes, bytes + size);
+    };
+
+    if (!stbi_write_png_to_func(append, png.get(), width, height, 4, rgba.data(), width * 4)) {
+        throw std::runtime_error("Couldn't encode image");
+    }
+
+    encodedData = std::move(png);
+}
 
 void Image::resize(int newWidth, int newHeight, uint32_t color) {
     int oldSize = this->width * this->height;
@@ -185,29 +217,13 @@ void Image::blendPixel(int x, int y, uint32_t foreCol) {
         return;
     }
 
-    // background
-    uint32_t *data = getPixels();
-    uint32_t color = data[y * width + x];
-    float ba = (int) ((color >> 24) & 0xFF) / 255.0;
-    float br = (int) ((color >> 16) & 0xFF) / 255.0;
-    float bg = (int) ((color >>  8) & 0xFF) / 255.0;
-    float bb = (int) ((color >>  0) & 0xFF) / 255.0;
-
-    // foreground
-    float fa = (int) ((foreCol >> 24) & 0xFF) / 255.0;
-    float fr = (int) ((foreCol >> 16) & 0xFF) / 255.0;
-    float fg = (int) ((foreCol >>  8) & 0xFF) / 255.0;
-    float fb = (int) ((foreCol >>  0) & 0xFF) / 255.0;
-
-    float a = fa + ba * (1 - fa);
-    float r = (fr * fa + br * ba * (1 - fa)) / a;
-    float g = (fg * fa + bg * ba * (1 - fa)) / a;
-    float b = (fb * fa + bb * ba * (1 - fa)) / a;
+    if ((foreCol & 0xFF000000) == 0) {
+        // nothing to blend, and blending onto a transparent pixel would divide by zero
+        return;
+    }
 
-    data[y * width + x] =  (uint8_t(a * 255) << 24)
-            | (uint8_t(r * 255) << 16)
-            | (uint8_t(g * 255) << 8)
-            | (uint8_t(b * 255) << 0);
+    uint32_t *data = getPixels();
+    data[y * width + x] = blendColors(data[y * width + x], foreCol);
 }
 
 void Image::drawLine(int x1, int y1, int x2, int y2, uint32_t color) {
@@ -587,6 +603,32 @@ void Image::copyTo(Image& dst, int srcX, int srcY) {
     }
 }
 
+void Image::scroll(int dx, int dy) {
+    if (dx == 0 && dy == 0) {
+        return;
+    }
+
+    if (std::abs(dx) >= width || std::abs(dy) >= height) {
+        return;
+    }
+
+    uint32_t *data = getPixels();
+    int rowLen = width - std::abs(dx);
+    int srcX = std::max(-dx, 0);
+    int dstX = std::max(dx, 0);
+
+    // iterate so that rows are read before they are overwritten
+    if (dy > 0) {
+        for (int y = height - 1; y >= dy; y--) {
+            std::memmove(data + y * width + dstX, data + (y - dy) * width + srcX, rowLen * sizeof(uint32_t));
+        }
+    } else {
+        for (int y = 0; y < height + dy; y++) {
+            std::memmove(data + y * width + dstX, data + (y - dy) * width + srcX, rowLen * sizeof(uint32_t));
+        }
+    }
+}
+
 void Image::blendImage(const Image& src, int dstX, int dstY, double angle) {
     int srcWidth = src.getWidth();
     int srcHeight = src.getHeight();
@@ -653,54 +695,25 @@ void Image::blendImage0(const Image& src, int dstX, int dstY) {
         return;
     }
 
-    //uint32_t *dstPtr = getPixels();
+    int x0 = std::max(dstX, 0);
+    int x1 = std::min(dstX + srcWidth, width);
+    int y0 = std::max(dstY, 0);
+    int y1 = std::min(dstY + srcHeight, height);
+    if (x0 >= x1) {
+        return;
+    }
+
+    uint32_t *dstPtr = getPixels();
     const uint32_t *srcPtr = src.getPixels();
 
-    for (int y = dstY; y < dstY + srcHeight; y++) {
-        for (int x = dstX; x < dstX + srcWidth; x++) {
-            int srcX = x - dstX;
-            int srcY = y - dstY;
-            if (srcX < 0 || srcX >= srcWidth|| srcY < 0 || srcY >= srcHeight) {
-                continue;
-            }
-            uint32_t srcColor = srcPtr[srcY * srcWidth + srcX];
-            if (srcColor & 0xFF000000) {
-                blendPixel(x, y, srcColor);
-            }
-        }
+    for (int y = y0; y < y1; y++) {
+        blendSpan(dstPtr + y * width + x0, srcPtr + (y - dstY) * srcWidth + (x0 - dstX), x1 - x0);
     }
 }
 
 void Image::alphaBlend(uint32_t color) {
-    // background
-    float ba = (int) ((color >> 24) & 0xFF) / 255.0;
-    float br = (int) ((color >> 16) & 0xFF) / 255.0;
-    float bg = (int) ((color >>  8) & 0xFF) / 255.0;
-    float bb = (int) ((color >>  0) & 0xFF) / 255.0;
-
-
-    for (int y = 0; y < height; y++) {
-        uint32_t *ptr = getPixels() + y * width;
-        for (int x = 0; x < width; x++) {
-            int foreCol = ptr[x];
-
-            // foreground
-            float fa = (int) ((foreCol >> 24) & 0xFF) / 255.0;
-            float fr = (int) ((foreCol >> 16) & 0xFF) / 255.0;
-            float fg = (int) ((foreCol >>  8) & 0xFF) / 255.0;
-            float fb = (int) ((foreCol >>  0) & 0xFF) / 255.0;
-
-            float a = fa + ba * (1 - fa);
-            float r = (fr * fa + br * ba * (1 - fa)) / a;
-            float g = (fg * fa + bg * ba * (1 - fa)) / a;
-            float b = (fb * fa + bb * ba * (1 - fa)) / a;
-
-            ptr[x] =  (uint8_t(a * 255) << 24)
-                    | (uint8_t(r * 255) << 16)
-                    | (uint8_t(g * 255) << 8)
-                    | (uint8_t(b * 255) << 0);
-        }
-    }
+    // color is the background
+    blendSpanOverColor(getPixels(), width * height, color);
 }
 
 void Image::rotate0(Image& dst) {
@@ -783,6 +796,48 @@ void Image::rotate270(Image &dst) {
     }
 }
 
+void Image::rotateFull(Image& dst, int angle) {
+    // transpose in blocks so that both images are accessed cache friendly
+    constexpr const int BLOCK = 32;
+
+    const uint32_t *srcPtr = getPixels();
+    uint32_t *dstPtr = dst.getPixels();
+
+    switch (angle) {
+    case 0:
+        std::copy(srcPtr, srcPtr + width * height, dstPtr);
+        break;
+    case 90:
+        for (int by = 0; by < dst.height; by += BLOCK) {
+            for (int bx = 0; bx < dst.width; bx += BLOCK) {
+                for (int y = by; y < std::min(by + BLOCK, dst.height); y++) {
+                    for (int x = bx; x < std::min(bx + BLOCK, dst.width); x++) {
+                        dstPtr[y * dst.width + x] = srcPtr[(height - 1 - x) * width + y];
+                    }
+                }
+            }
+        }
+        break;
+    case 180:
+        for (int y = 0; y < dst.height; y++) {
+            const uint32_t *srcRow = srcPtr + (height - 1 - y) * width;
+            std::reverse_copy(srcRow, srcRow + width, dstPtr + y * dst.width);
+        }
+        break;
+    case 270:
+        for (int by = 0; by < dst.height; by += BLOCK) {
+            for (int bx = 0; bx < dst.width; bx += BLOCK) {
+                for (int y = by; y < std::min(by + BLOCK, dst.height); y++) {
+                    for (int x = bx; x < std::min(bx + BLOCK, dst.width); x++) {
+                        dstPtr[y * dst.width + x] = srcPtr[x * width + (width - 1 - y)];
+                    }
+                }
+            }
+        }
+        break;
+    }
+}
+
 void Image::rotate(Image& dst, int angle) {
     dst.clear(0);
     switch (angle) {
@@ -64,6 +64,11 @@ public:
 
     // No effect if not loaded via loadEncodedData!
     void storeAndClearEncodedData(const std::string &utf8Path);
+    std::vector<uint8_t> takeEncodedData();
+    bool hasEncodedData() const;
+
+    // Replaces the encoded data with the pixels as PNG so that the image can be stored like a loaded one
+    void encodePNG();
 
     int getWidth() const;
     int getHeight() const;
@@ -77,6 +82,7 @@ public:
     void drawLineAA(float x0, float y0, float x1, float y1, uint32_t color);
     void drawImage(const Image &src, int dstX, int dstY);
     void copyTo(Image &dst, int srcX, int srcY);
+    void scroll(int dx, int dy); // the uncovered area keeps its old content
     void blendImage(const Image &src, int dstX, int dstY, double angle);
     void blendImage270(const Image &src, int dstX, int dstY);
     void blendImage0(const Image &src, int dstX, int dstY);
@@ -97,6 +103,9 @@ public:
     void rotate270(Image &dst);
     void rotate(Image &dst, int angle);
 
+    // dst must have the rotated dimensions, i.e. width and height swapped for 90 and 270
+    void rotateFull(Image &dst, int angle);
+
     virtual ~Image() = default;
 private:
     int width = 0;
@@ -0,0 +1,336 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <array>
+#include "PixelKernels.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#   define AVITAB_SSE2 1
+#   include <emmintrin.h>
+// MinGW doesn't align the stack for spilled 256 bit registers
+#   if !defined(_WIN32)
+#       define AVITAB_AVX2 1
+#       include <immintrin.h>
+#   endif
+#endif
+
+namespace img {
+
+namespace {
+
+// same values as (int) c / 255.0 converted to float
+const std::array<float, 256> channelToFloat = [] () {
+    std::array<float, 256> res;
+    for (int i = 0; i < 256; i++) {
+        res[i] = i / 255.0;
+    }
+    return res;
+}();
+
+SimdLevel detectSimdLevel() {
+#ifdef AVITAB_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdLevel::AVX2;
+    }
+#endif
+#ifdef AVITAB_SSE2
+    return SimdLevel::SSE2;
+#else
+    return SimdLevel::NONE;
+#endif
+}
+
+const SimdLevel supportedSimdLevel = detectSimdLevel();
+SimdLevel simdLevel = supportedSimdLevel;
+
+void convertRGBAToARGBScalar(const uint8_t *src, uint32_t *dst, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t *p = src + i * 4;
+        dst[i] = (p[3] << 24) | (p[0] << 16) | (p[1] << 8) | p[2];
+    }
+}
+
+void blendSpanScalar(uint32_t *dst, const uint32_t *src, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (src[i] & 0xFF000000) {
+            dst[i] = blendColors(dst[i], src[i]);
+        }
+    }
+}
+
+void blendSpanOverColorScalar(uint32_t *pixels, size_t count, uint32_t background) {
+    for (size_t i = 0; i < count; i++) {
+        pixels[i] = blendColors(background, pixels[i]);
+    }
+}
+
+#ifdef AVITAB_SSE2
+
+// The vector versions perform the same float operations in the same order as
+// blendColors. Channel / 255.0f is exact for all 256 channel values and the
+// float to int conversion truncates like the scalar cast.
+
+inline __m128 channelSSE2(__m128i v, int shift) {
+    __m128i c = _mm_and_si128(_mm_srli_epi32(v, shift), _mm_set1_epi32(0xFF));
+    return _mm_div_ps(_mm_cvtepi32_ps(c), _mm_set1_ps(255.0f));
+}
+
+inline __m128i toChannelSSE2(__m128 v, int shift) {
+    __m128i c = _mm_cvttps_epi32(_mm_mul_ps(v, _mm_set1_ps(255.0f)));
+    return _mm_slli_epi32(_mm_and_si128(c, _mm_set1_epi32(0xFF)), shift);
+}
+
+inline __m128i blendSSE2(__m128i back, __m128i fore) {
+    __m128 ba = channelSSE2(back, 24);
+    __m128 br = channelSSE2(back, 16);
+    __m128 bg = channelSSE2(back, 8);
+    __m128 bb = channelSSE2(back, 0);
+
+    __m128 fa = channelSSE2(fore, 24);
+    __m128 fr = channelSSE2(fore, 16);
+    __m128 fg = channelSSE2(fore, 8);
+    __m128 fb = channelSSE2(fore, 0);
+
+    __m128 inv = _mm_sub_ps(_mm_set1_ps(1.0f), fa);
+    __m128 a = _mm_add_ps(fa, _mm_mul_ps(ba, inv));
+    __m128 r = _mm_div_ps(_mm_add_ps(_mm_mul_ps(fr, fa), _mm_mul_ps(_mm_mul_ps(br, ba), inv)), a);
+    __m128 g = _mm_div_ps(_mm_add_ps(_mm_mul_ps(fg, fa), _mm_mul_ps(_mm_mul_ps(bg, ba), inv)), a);
+    __m128 b = _mm_div_ps(_mm_add_ps(_mm_mul_ps(fb, fa), _mm_mul_ps(_mm_mul_ps(bb, ba), inv)), a);
+
+    return _mm_or_si128(_mm_or_si128(toChannelSSE2(a, 24), toChannelSSE2(r, 16)),
+                        _mm_or_si128(toChannelSSE2(g, 8), toChannelSSE2(b, 0)));
+}
+
+void convertRGBAToARGBSSE2(const uint8_t *src, uint32_t *dst, size_t count) {
+    // little endian: RGBA bytes are 0xAABBGGRR, swap R and B
+    const __m128i keep = _mm_set1_epi32(0xFF00FF00);
+    const __m128i low = _mm_set1_epi32(0xFF);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i * 4));
+        __m128i res = _mm_or_si128(_mm_and_si128(v, keep),
+                      _mm_or_si128(_mm_slli_epi32(_mm_and_si128(v, low), 16),
+                                   _mm_and_si128(_mm_srli_epi32(v, 16), low)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), res);
+    }
+    convertRGBAToARGBScalar(src + i * 4, dst + i, count - i);
+}
+
+void blendSpanSSE2(uint32_t *dst, const uint32_t *src, size_t count) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i opaque = _mm_set1_epi32(0xFF);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i fore = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128i alpha = _mm_srli_epi32(fore, 24);
+        __m128i transparent = _mm_cmpeq_epi32(alpha, zero);
+        if (_mm_movemask_epi8(transparent) == 0xFFFF) {
+            continue;
+        }
+
+        __m128i *dstPtr = reinterpret_cast<__m128i *>(dst + i);
+        __m128i back = _mm_loadu_si128(dstPtr);
+        __m128i res;
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, opaque)) == 0xFFFF) {
+            // blending opaque pixels yields the foreground
+            res = fore;
+        } else {
+            res = blendSSE2(back, fore);
+        }
+        res = _mm_or_si128(_mm_and_si128(transparent, back), _mm_andnot_si128(transparent, res));
+        _mm_storeu_si128(dstPtr, res);
+    }
+    blendSpanScalar(dst + i, src + i, count - i);
+}
+
+void blendSpanOverColorSSE2(uint32_t *pixels, size_t count, uint32_t background) {
+    const __m128i back = _mm_set1_epi32(background);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i *ptr = reinterpret_cast<__m128i *>(pixels + i);
+        _mm_storeu_si128(ptr, blendSSE2(back, _mm_loadu_si128(ptr)));
+    }
+    blendSpanOverColorScalar(pixels + i, count - i, background);
+}
+
+#endif
+
+#ifdef AVITAB_AVX2
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+AVX2_TARGET inline __m256 channelAVX2(__m256i v, int shift) {
+    __m256i c = _mm256_and_si256(_mm256_srli_epi32(v, shift), _mm256_set1_epi32(0xFF));
+    return _mm256_div_ps(_mm256_cvtepi32_ps(c), _mm256_set1_ps(255.0f));
+}
+
+AVX2_TARGET inline __m256i toChannelAVX2(__m256 v, int shift) {
+    __m256i c = _mm256_cvttps_epi32(_mm256_mul_ps(v, _mm256_set1_ps(255.0f)));
+    return _mm256_slli_epi32(_mm256_and_si256(c, _mm256_set1_epi32(0xFF)), shift);
+}
+
+AVX2_TARGET inline __m256i blendAVX2(__m256i back, __m256i fore) {
+    __m256 ba = channelAVX2(back, 24);
+    __m256 br = channelAVX2(back, 16);
+    __m256 bg = channelAVX2(back, 8);
+    __m256 bb = channelAVX2(back, 0);
+
+    __m256 fa = channelAVX2(fore, 24);
+    __m256 fr = channelAVX2(fore, 16);
+    __m256 fg = channelAVX2(fore, 8);
+    __m256 fb = channelAVX2(fore, 0);
+
+    __m256 inv = _mm256_sub_ps(_mm256_set1_ps(1.0f), fa);
+    __m256 a = _mm256_add_ps(fa, _mm256_mul_ps(ba, inv));
+    __m256 r = _mm256_div_ps(_mm256_add_ps(_mm256_mul_ps(fr, fa), _mm256_mul_ps(_mm256_mul_ps(br, ba), inv)), a);
+    __m256 g = _mm256_div_ps(_mm256_add_ps(_mm256_mul_ps(fg, fa), _mm256_mul_ps(_mm256_mul_ps(bg, ba), inv)), a);
+    __m256 b = _mm256_div_ps(_mm256_add_ps(_mm256_mul_ps(fb, fa), _mm256_mul_ps(_mm256_mul_ps(bb, ba), inv)), a);
+
+    return _mm256_or_si256(_mm256_or_si256(toChannelAVX2(a, 24), toChannelAVX2(r, 16)),
+                           _mm256_or_si256(toChannelAVX2(g, 8), toChannelAVX2(b, 0)));
+}
+
+AVX2_TARGET void convertRGBAToARGBAVX2(const uint8_t *src, uint32_t *dst, size_t count) {
+    const __m256i swap = _mm256_setr_epi8(
+            2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+            2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i * 4));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_shuffle_epi8(v, swap));
+    }
+    convertRGBAToARGBScalar(src + i * 4, dst + i, count - i);
+}
+
+AVX2_TARGET void blendSpanAVX2(uint32_t *dst, const uint32_t *src, size_t count) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i opaque = _mm256_set1_epi32(0xFF);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i fore = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        __m256i alpha = _mm256_srli_epi32(fore, 24);
+        __m256i transparent = _mm256_cmpeq_epi32(alpha, zero);
+        if (_mm256_movemask_epi8(transparent) == -1) {
+            continue;
+        }
+
+        __m256i *dstPtr = reinterpret_cast<__m256i *>(dst + i);
+        __m256i back = _mm256_loadu_si256(dstPtr);
+        __m256i res;
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, opaque)) == -1) {
+            res = fore;
+        } else {
+            res = blendAVX2(back, fore);
+        }
+        res = _mm256_blendv_epi8(res, back, transparent);
+        _mm256_storeu_si256(dstPtr, res);
+    }
+    blendSpanScalar(dst + i, src + i, count - i);
+}
+
+AVX2_TARGET void blendSpanOverColorAVX2(uint32_t *pixels, size_t count, uint32_t background) {
+    const __m256i back = _mm256_set1_epi32(background);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i *ptr = reinterpret_cast<__m256i *>(pixels + i);
+        _mm256_storeu_si256(ptr, blendAVX2(back, _mm256_loadu_si256(ptr)));
+    }
+    blendSpanOverColorScalar(pixels + i, count - i, background);
+}
+
+#endif
+
+} // anonymous namespace
+
+SimdLevel getSupportedSimdLevel() {
+    return supportedSimdLevel;
+}
+
+bool setSimdLevel(SimdLevel level) {
+    if (level > supportedSimdLevel) {
+        return false;
+    }
+    simdLevel = level;
+    return true;
+}
+
+void convertRGBAToARGB(const uint8_t *src, uint32_t *dst, size_t count) {
+    switch (simdLevel) {
+#ifdef AVITAB_AVX2
+    case SimdLevel::AVX2:   convertRGBAToARGBAVX2(src, dst, count); break;
+#endif
+#ifdef AVITAB_SSE2
+    case SimdLevel::SSE2:   convertRGBAToARGBSSE2(src, dst, count); break;
+#endif
+    default:                convertRGBAToARGBScalar(src, dst, count); break;
+    }
+}
+
+uint32_t blendColors(uint32_t back, uint32_t fore) {
+    float ba = channelToFloat[(back >> 24) & 0xFF];
+    float br = channelToFloat[(back >> 16) & 0xFF];
+    float bg = channelToFloat[(back >>  8) & 0xFF];
+    float bb = channelToFloat[(back >>  0) & 0xFF];
+
+    float fa = channelToFloat[(fore >> 24) & 0xFF];
+    float fr = channelToFloat[(fore >> 16) & 0xFF];
+    float fg = channelToFloat[(fore >>  8) & 0xFF];
+    float fb = channelToFloat[(fore >>  0) & 0xFF];
+
+    float a = fa + ba * (1 - fa);
+    float r = (fr * fa + br * ba * (1 - fa)) / a;
+    float g = (fg * fa + bg * ba * (1 - fa)) / a;
+    float b = (fb * fa + bb * ba * (1 - fa)) / a;
+
+    return (uint8_t(a * 255) << 24)
+         | (uint8_t(r * 255) << 16)
+         | (uint8_t(g * 255) << 8)
+         | (uint8_t(b * 255) << 0);
+}
+
+void blendSpan(uint32_t *dst, const uint32_t *src, size_t count) {
+    switch (simdLevel) {
+#ifdef AVITAB_AVX2
+    case SimdLevel::AVX2:   blendSpanAVX2(dst, src, count); break;
+#endif
+#ifdef AVITAB_SSE2
+    case SimdLevel::SSE2:   blendSpanSSE2(dst, src, count); break;
+#endif
+    default:                blendSpanScalar(dst, src, count); break;
+    }
+}
+
+void blendSpanOverColor(uint32_t *pixels, size_t count, uint32_t background) {
+    switch (simdLevel) {
+#ifdef AVITAB_AVX2
+    case SimdLevel::AVX2:   blendSpanOverColorAVX2(pixels, count, background); break;
+#endif
+#ifdef AVITAB_SSE2
+    case SimdLevel::SSE2:   blendSpanOverColorSSE2(pixels, count, background); break;
+#endif
+    default:                blendSpanOverColorScalar(pixels, count, background); break;
+    }
+}
+
+} /* namespace img */
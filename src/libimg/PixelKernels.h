@@ -0,0 +1,55 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SRC_LIBIMG_PIXELKERNELS_H_
+#define SRC_LIBIMG_PIXELKERNELS_H_
+
+#include <cstdint>
+#include <cstddef>
+
+namespace img {
+
+// Pixel loops used by Image. SSE2 or AVX2 is used if the CPU supports it,
+// the results are bit-identical to the scalar versions.
+
+enum class SimdLevel {
+    NONE,
+    SSE2,
+    AVX2,
+};
+
+// The best level supported by the CPU and the build, used by default
+SimdLevel getSupportedSimdLevel();
+
+// For tests: selects the kernels, returns false if the level isn't supported
+bool setSimdLevel(SimdLevel level);
+
+// RGBA bytes as returned by stb_image to ARGB pixels
+void convertRGBAToARGB(const uint8_t *src, uint32_t *dst, size_t count);
+
+// Blends fore over back
+uint32_t blendColors(uint32_t back, uint32_t fore);
+
+// Blends each source pixel over the destination, fully transparent source pixels are skipped
+void blendSpan(uint32_t *dst, const uint32_t *src, size_t count);
+
+// Blends each pixel over the given background color
+void blendSpanOverColor(uint32_t *pixels, size_t count, uint32_t background);
+
+} /* namespace img */
+
+#endif /* SRC_LIBIMG_PIXELKERNELS_H_ */
@@ -0,0 +1,47 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "DirectoryTileStore.h"
+#include "src/platform/Platform.h"
+
+namespace img {
+
+DirectoryTileStore::DirectoryTileStore(const std::string& utf8Dir):
+    baseDir(utf8Dir)
+{
+}
+
+std::shared_ptr<Image> DirectoryTileStore::loadTile(const std::string& name) {
+    std::string fileName = baseDir + "/" + name;
+    if (!platform::fileExists(fileName)) {
+        return nullptr;
+    }
+
+    auto img = std::make_shared<Image>();
+    img->loadImageFile(fileName);
+    return img;
+}
+
+void DirectoryTileStore::storeTile(const std::string& name, Image& image) {
+    image.storeAndClearEncodedData(baseDir + "/" + name);
+}
+
+bool DirectoryTileStore::hasTile(const std::string& name) {
+    return platform::fileExists(baseDir + "/" + name);
+}
+
+} /* namespace img */
@@ -0,0 +1,41 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SRC_LIBIMG_STITCHER_DIRECTORYTILESTORE_H_
+#define SRC_LIBIMG_STITCHER_DIRECTORYTILESTORE_H_
+
+#include <string>
+#include "TileStore.h"
+
+namespace img {
+
+// Stores each tile as an individual file below a directory
+class DirectoryTileStore: public TileStore {
+public:
+    DirectoryTileStore(const std::string &utf8Dir);
+
+    std::shared_ptr<Image> loadTile(const std::string &name) override;
+    void storeTile(const std::string &name, Image &image) override;
+    bool hasTile(const std::string &name) override;
+
+private:
+    std::string baseDir;
+};
+
+} /* namespace img */
+
+#endif /* SRC_LIBIMG_STITCHER_DIRECTORYTILESTORE_H_ */
@@ -0,0 +1,254 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <map>
+#include <vector>
+#include <stdexcept>
+#include "RawTileCache.h"
+#include "src/Logger.h"
+
+namespace img {
+
+std::shared_ptr<RawTileCache> RawTileCache::open(const std::string& utf8Dir, size_t bytes) {
+    static std::mutex registryMutex;
+    static std::map<std::string, std::weak_ptr<RawTileCache>> registry;
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto cache = registry[utf8Dir].lock();
+    if (!cache) {
+        cache = std::make_shared<RawTileCache>(utf8Dir, bytes);
+        registry[utf8Dir] = cache;
+    }
+    return cache;
+}
+
+RawTileCache::RawTileCache(const std::string& utf8Dir, size_t bytes):
+    path(utf8Dir + "/" + FILE_NAME)
+{
+    slotCount = std::max<uint64_t>(1, bytes / SLOT_SIZE);
+
+    if (!openExisting()) {
+        // a different size or an unknown version: start over
+        create();
+    }
+
+    scanSlots();
+    logger::verbose("Opened raw tile cache %s with %d / %d slots used", path.c_str(), (int) index.size(), (int) slotCount);
+}
+
+bool RawTileCache::openExisting() {
+    if (!platform::fileExists(path)) {
+        return false;
+    }
+
+    file.open(fs::u8path(path), std::ios::in | std::ios::out | std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    uint32_t header[4];
+    file.read(reinterpret_cast<char *>(header), sizeof(header));
+    if (!file || header[0] != FILE_MAGIC || header[1] != VERSION || header[2] != slotCount) {
+        file.close();
+        return false;
+    }
+
+    if (fs::file_size(fs::u8path(path)) != FILE_HEADER_SIZE + slotCount * SLOT_SIZE) {
+        file.close();
+        return false;
+    }
+
+    return true;
+}
+
+void RawTileCache::create() {
+    {
+        fs::ofstream out(fs::u8path(path), std::ios::out | std::ios::trunc | std::ios::binary);
+        uint32_t header[4] = {FILE_MAGIC, VERSION, slotCount, 0};
+        out.write(reinterpret_cast<const char *>(header), sizeof(header));
+        if (!out) {
+            throw std::runtime_error("Couldn't create raw tile cache " + path);
+        }
+    }
+
+    // sparse on most file systems, empty slots read as zero
+    fs::resize_file(fs::u8path(path), FILE_HEADER_SIZE + slotCount * SLOT_SIZE);
+
+    file.open(fs::u8path(path), std::ios::in | std::ios::out | std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Couldn't open raw tile cache " + path);
+    }
+}
+
+void RawTileCache::scanSlots() {
+    uint64_t newestSequence = 0;
+    std::string name;
+
+    for (uint32_t slot = 0; slot < slotCount; slot++) {
+        SlotHeader header;
+        file.seekg(slotOffset(slot));
+        file.read(reinterpret_cast<char *>(&header), sizeof(header));
+        if (!file) {
+            file.clear();
+            break;
+        }
+
+        if (header.sequence == 0 || header.nameLen == 0 || header.nameLen > MAX_NAME_LENGTH ||
+                header.width > MAX_TILE_SIZE || header.height > MAX_TILE_SIZE) {
+            continue;
+        }
+
+        name.resize(header.nameLen);
+        file.seekg(slotOffset(slot) + SLOT_FIXED_SIZE);
+        file.read(&name[0], header.nameLen);
+        if (!file) {
+            file.clear();
+            continue;
+        }
+
+        index[name] = slot;
+        slotNames[slot] = name;
+
+        if (header.sequence > newestSequence) {
+            newestSequence = header.sequence;
+            nextSlot = (slot + 1) % slotCount;
+        }
+    }
+
+    nextSequence = newestSequence + 1;
+}
+
+uint64_t RawTileCache::slotOffset(uint32_t slot) const {
+    return FILE_HEADER_SIZE + slot * SLOT_SIZE;
+}
+
+std::shared_ptr<Image> RawTileCache::loadTile(const std::string& name) {
+    std::lock_guard<std::mutex> lock(fileMutex);
+
+    auto it = index.find(name);
+    if (it == index.end()) {
+        return nullptr;
+    }
+
+    uint32_t slot = it->second;
+    SlotHeader header;
+    file.seekg(slotOffset(slot));
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!file) {
+        file.clear();
+        return nullptr;
+    }
+
+    auto img = std::make_shared<Image>(header.width, header.height, 0);
+    file.seekg(slotOffset(slot) + SLOT_HEADER_SIZE);
+    file.read(reinterpret_cast<char *>(img->getPixels()), header.width * header.height * sizeof(uint32_t));
+    if (!file) {
+        file.clear();
+        return nullptr;
+    }
+
+    return img;
+}
+
+void RawTileCache::storeTile(const std::string& name, const Image& image) {
+    int width = image.getWidth();
+    int height = image.getHeight();
+    if (width <= 0 || height <= 0 || width > MAX_TILE_SIZE || height > MAX_TILE_SIZE) {
+        return;
+    }
+
+    if (name.empty() || name.size() > MAX_NAME_LENGTH) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(fileMutex);
+    if (index.find(name) != index.end()) {
+        return;
+    }
+
+    uint32_t slot = nextSlot;
+    nextSlot = (nextSlot + 1) % slotCount;
+
+    auto old = slotNames.find(slot);
+    if (old != slotNames.end()) {
+        index.erase(old->second);
+        slotNames.erase(old);
+    }
+
+    // invalidate the slot first so that an interrupted write isn't used later
+    SlotHeader header {};
+    file.seekp(slotOffset(slot));
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    file.seekp(slotOffset(slot) + SLOT_HEADER_SIZE);
+    file.write(reinterpret_cast<const char *>(image.getPixels()), width * height * sizeof(uint32_t));
+    file.flush();
+
+    header.sequence = nextSequence++;
+    header.nameLen = name.size();
+    header.width = width;
+    header.height = height;
+    file.seekp(slotOffset(slot));
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(name.data(), name.size());
+    file.flush();
+
+    if (!file) {
+        file.clear();
+        logger::warn("Couldn't write to raw tile cache %s", path.c_str());
+        return;
+    }
+
+    index[name] = slot;
+    slotNames[slot] = name;
+}
+
+void RawTileCache::removeTile(const std::string& name) {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    auto it = index.find(name);
+    if (it != index.end()) {
+        releaseSlot(it->second);
+    }
+}
+
+void RawTileCache::clear() {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    while (!slotNames.empty()) {
+        releaseSlot(slotNames.begin()->first);
+    }
+}
+
+void RawTileCache::releaseSlot(uint32_t slot) {
+    // gets called with locked mutex, the slot stays in the FIFO order
+    auto it = slotNames.find(slot);
+    if (it != slotNames.end()) {
+        index.erase(it->second);
+        slotNames.erase(it);
+    }
+
+    // an empty header so that the tile is also gone after a restart
+    SlotHeader header {};
+    file.seekp(slotOffset(slot));
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.flush();
+    if (!file) {
+        file.clear();
+        logger::warn("Couldn't write to raw tile cache %s", path.c_str());
+    }
+}
+
+} /* namespace img */
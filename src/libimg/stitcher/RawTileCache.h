@@ -0,0 +1,97 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SRC_LIBIMG_STITCHER_RAWTILECACHE_H_
+#define SRC_LIBIMG_STITCHER_RAWTILECACHE_H_
+
+#include <cstdint>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "src/libimg/Image.h"
+#include "src/platform/Platform.h"
+
+namespace img {
+
+/*
+ * Keeps already decoded tiles in a file of fixed size slots so that a
+ * hit is a plain read into the pixel buffer instead of a PNG / JPEG decode.
+ * Slots are reused in FIFO order once the file is full.
+ *
+ * File:  "AVRC", u32 version, u32 slotCount, u32 reserved, then slots of
+ *        u64 sequence, u32 nameLen, u32 width, u32 height, u32 reserved,
+ *        name (padded to SLOT_HEADER_SIZE), pixels (padded to MAX_TILE_SIZE^2)
+ *
+ * Pixels are stored as in Image, i.e. ARGB in native byte order.
+ */
+class RawTileCache {
+public:
+    static constexpr const char *FILE_NAME = "tiles.raw";
+    static constexpr const int MAX_TILE_SIZE = 256;
+
+    // Caches using the same directory share the same file
+    static std::shared_ptr<RawTileCache> open(const std::string &utf8Dir, size_t bytes);
+
+    RawTileCache(const std::string &utf8Dir, size_t bytes);
+
+    // Returns nullptr if the tile is not cached
+    std::shared_ptr<Image> loadTile(const std::string &name);
+
+    // Tiles larger than MAX_TILE_SIZE are ignored
+    void storeTile(const std::string &name, const Image &image);
+
+    // Must be called when the tile store gets a new version of a tile
+    void removeTile(const std::string &name);
+    void clear();
+
+private:
+    static constexpr const uint32_t FILE_MAGIC = 0x43525641; // "AVRC"
+    static constexpr const uint32_t VERSION = 1;
+    static constexpr const uint64_t FILE_HEADER_SIZE = 16;
+    static constexpr const uint64_t SLOT_HEADER_SIZE = 256;
+    static constexpr const uint64_t SLOT_FIXED_SIZE = 24;
+    static constexpr const uint64_t MAX_NAME_LENGTH = SLOT_HEADER_SIZE - SLOT_FIXED_SIZE;
+    static constexpr const uint64_t SLOT_SIZE = SLOT_HEADER_SIZE + MAX_TILE_SIZE * MAX_TILE_SIZE * sizeof(uint32_t);
+
+    struct SlotHeader {
+        uint64_t sequence;
+        uint32_t nameLen;
+        uint32_t width;
+        uint32_t height;
+        uint32_t reserved;
+    };
+
+    std::string path;
+    std::mutex fileMutex;
+    fs::fstream file;
+    uint32_t slotCount = 0;
+    uint32_t nextSlot = 0;
+    uint64_t nextSequence = 1;
+    std::unordered_map<std::string, uint32_t> index;
+    std::unordered_map<uint32_t, std::string> slotNames;
+
+    bool openExisting();
+    void create();
+    void scanSlots();
+    uint64_t slotOffset(uint32_t slot) const;
+    void releaseSlot(uint32_t slot);
+};
+
+} /* namespace img */
+
+#endif /* SRC_LIBIMG_STITCHER_RAWTILECACHE_H_ */
@@ -16,12 +16,16 @@
  *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include <cmath>
+#include <algorithm>
 #include "Stitcher.h"
 #include "src/Logger.h"
 
 namespace img {
 
 Stitcher::Stitcher(std::shared_ptr<Image> dstImage, std::shared_ptr<TileSource> source):
+    emptyTile(std::make_shared<Image>()),
+    errorTile(std::make_shared<Image>()),
+    loadingTile(std::make_shared<Image>()),
     dstImage(dstImage),
     tileSource(source),
     tileCache(source)
@@ -31,12 +35,31 @@ Stitcher::Stitcher(std::shared_ptr<Image> dstImage, std::shared_ptr<TileSource>
     centerX = center.x;
     centerY = center.y;
 
-    int max = std::max(dstImage->getWidth(), dstImage->getHeight());
-    unrotatedImage = std::make_shared<Image>(max, max, 0);
+    setupLayers();
 }
 
-void Stitcher::setCacheDirectory(const std::string& utf8Path) {
-    tileCache.setCacheDirectory(utf8Path);
+void Stitcher::setupLayers() {
+    int width = dstImage->getWidth();
+    int height = dstImage->getHeight();
+    if (rotAngle == 90 || rotAngle == 270) {
+        std::swap(width, height);
+    }
+
+    if (rotAngle == 0) {
+        // compose and draw the overlays directly into the target
+        unrotatedImage = dstImage;
+    } else if (!unrotatedImage || unrotatedImage == dstImage) {
+        unrotatedImage = std::make_shared<Image>(width, height, 0);
+    } else {
+        unrotatedImage->resize(width, height, 0);
+    }
+
+    tileLayer.resize(width, height, 0);
+    tileLayerValid = false;
+}
+
+void Stitcher::setCacheDirectory(const std::string& utf8Path, size_t rawCacheBytes) {
+    tileCache.setCacheDirectory(utf8Path, rawCacheBytes);
 }
 
 void Stitcher::setRedrawCallback(RedrawCallback cb) {
@@ -59,10 +82,25 @@ img::Point<double> Stitcher::getCenter() const {
     return img::Point<double>{centerX, centerY};
 }
 
+void Stitcher::setPriorityPoint(double x, double y) {
+    hasPriorityPoint = true;
+    priorityX = x;
+    priorityY = y;
+    tileCache.setPriorityPoint(x, y);
+}
+
+void Stitcher::clearPriorityPoint() {
+    hasPriorityPoint = false;
+    tileCache.clearPriorityPoint();
+}
+
+void Stitcher::setPrefetchTiles(const std::vector<TileCache::TileCoords> &tiles) {
+    tileCache.setPrefetchTiles(tiles);
+}
+
 void Stitcher::nextPage() {
     if (page + 1 < tileSource->getPageCount()) {
         page++;
-        tileCache.cancelPendingRequests();
         updateImage();
     }
 }
@@ -70,7 +108,6 @@ void Stitcher::nextPage() {
 void Stitcher::prevPage() {
     if (page > 0) {
         page--;
-        tileCache.cancelPendingRequests();
         updateImage();
     }
 }
@@ -114,9 +151,18 @@ void Stitcher::setZoomLevel(int level) {
     auto newCenterXY = tileSource->transformZoomedPoint(page, centerX, centerY, zoomLevel, level);
     centerX = newCenterXY.x;
     centerY = newCenterXY.y;
+    if (hasPriorityPoint) {
+        auto newPriorityXY = tileSource->transformZoomedPoint(page, priorityX, priorityY, zoomLevel, level);
+        priorityX = newPriorityXY.x;
+        priorityY = newPriorityXY.y;
+    }
     zoomLevel = level;
 
-    tileCache.cancelPendingRequests();
+    // pending tiles of the old zoom level are demoted or dropped by the cache
+    tileCache.setViewport(page, zoomLevel, centerX, centerY);
+    if (hasPriorityPoint) {
+        tileCache.setPriorityPoint(priorityX, priorityY);
+    }
 
     updateImage();
 }
@@ -139,43 +185,55 @@ std::shared_ptr<TileSource> Stitcher::getTileSource() {
 
 void Stitcher::rotateRight() {
     rotAngle = (rotAngle + 90) % 360;
+    setupLayers();
     updateImage();
 }
 
-void Stitcher::forEachTileInView(std::function<void(int, int, img::Image &)> f) {
+Stitcher::ViewLayout Stitcher::getViewLayout() {
     auto dim = tileSource->getTileDimensions(zoomLevel);
-    int tileEdgeWidth = dim.x;
-    int tileEdgeHeight = dim.y;
-    int dstWidth = unrotatedImage->getWidth();
-    int dstHeight = unrotatedImage->getHeight();
+    int dstWidth = tileLayer.getWidth();
+    int dstHeight = tileLayer.getHeight();
 
-    // The center pixel's position offset inside the center tile
-    int xOff = (centerX - (int) centerX) * tileEdgeWidth;
-    int yOff = (centerY - (int) centerY) * tileEdgeHeight;
+    ViewLayout layout;
+    layout.tileWidth = dim.x;
+    layout.tileHeight = dim.y;
 
-    // Center tile's upper left position so that the center pixel's position will be at the image center
-    int centerPosX = dstWidth / 2 - xOff;
-    int centerPosY = dstHeight / 2 - yOff;
+    layout.xOff = (centerX - (int) centerX) * layout.tileWidth;
+    layout.yOff = (centerY - (int) centerY) * layout.tileHeight;
+
+    // so that the center pixel's position will be at the image center
+    layout.centerPosX = dstWidth / 2 - layout.xOff;
+    layout.centerPosY = dstHeight / 2 - layout.yOff;
+
+    layout.radiusX = (dstWidth / 2.0) / layout.tileWidth + 1;
+    layout.radiusY = (dstHeight / 2.0) / layout.tileHeight + 1;
+
+    layout.originX = ((int) centerX) * layout.tileWidth - layout.centerPosX;
+    layout.originY = ((int) centerY) * layout.tileHeight - layout.centerPosY;
+
+    return layout;
+}
 
-    int radiusX = (dstWidth / 2.0) / tileEdgeWidth + 1;
-    int radiusY = (dstHeight / 2.0) / tileEdgeHeight + 1;
+void Stitcher::forEachTileInView(const ViewLayout &layout, TileFunction f) {
+    int tileEdgeWidth = layout.tileWidth;
+    int tileEdgeHeight = layout.tileHeight;
 
-    emptyTile.resize(tileEdgeWidth, tileEdgeHeight, img::COLOR_TRANSPARENT);
-    errorTile.resize(tileEdgeWidth, tileEdgeHeight, img::COLOR_RED);
-    loadingTile.resize(tileEdgeWidth, tileEdgeHeight, img::COLOR_BLACK);
+    emptyTile->resize(tileEdgeWidth, tileEdgeHeight, img::COLOR_TRANSPARENT);
+    errorTile->resize(tileEdgeWidth, tileEdgeHeight, img::COLOR_RED);
+    loadingTile->resize(tileEdgeWidth, tileEdgeHeight, img::COLOR_BLACK);
 
-    pendingTiles = false;
+    tileCache.setViewport(page, zoomLevel, centerX, centerY);
 
-    for (int y = -radiusY; y <= radiusY; y++) {
-        for (int x = -radiusX; x <= radiusX; x++) {
+    for (int y = -layout.radiusY; y <= layout.radiusY; y++) {
+        for (int x = -layout.radiusX; x <= layout.radiusX; x++) {
             int tileX = ((int) centerX) + x;
             int tileY = ((int) centerY) + y;
 
-            int tilePosX = centerPosX + x * tileEdgeWidth;
-            int tilePosY = centerPosY + y * tileEdgeHeight;
+            int tilePosX = layout.centerPosX + x * tileEdgeWidth;
+            int tilePosY = layout.centerPosY + y * tileEdgeHeight;
 
             if (!tileSource->isTileValid(page, tileX, tileY, zoomLevel)) {
-                f(tilePosX, tilePosY, emptyTile);
+                f(tileX, tileY, tilePosX, tilePosY, emptyTile);
                 continue;
             }
 
@@ -183,15 +241,14 @@ void Stitcher::forEachTileInView(std::function<void(int, int, img::Image &)> f)
             try {
                 tile = tileCache.getTile(page, tileX, tileY, zoomLevel);
             } catch (const std::exception &e) {
-                f(tilePosX, tilePosY, errorTile);
+                f(tileX, tileY, tilePosX, tilePosY, errorTile);
                 continue;
             }
 
             if (tile) {
-                f(tilePosX, tilePosY, *tile);
+                f(tileX, tileY, tilePosX, tilePosY, tile);
             } else {
-                pendingTiles = true;
-                f(tilePosX, tilePosY, loadingTile);
+                f(tileX, tileY, tilePosX, tilePosY, loadingTile);
             }
         }
     }
@@ -199,36 +256,91 @@ void Stitcher::forEachTileInView(std::function<void(int, int, img::Image &)> f)
     // Due to rounding and precision, the actual drawn center will be a few
     // pixels off the requested center.
     // Ensure that we return the actual drawn center instead of the requested one.
-    centerX = ((int) centerX) + xOff / (double) tileEdgeWidth;
-    centerY = ((int) centerY) + yOff / (double) tileEdgeHeight;
+    centerX = ((int) centerX) + layout.xOff / (double) tileEdgeWidth;
+    centerY = ((int) centerY) + layout.yOff / (double) tileEdgeHeight;
 }
 
-void Stitcher::updateImage() {
-    forEachTileInView([this] (int x, int y, img::Image &tile) {
-        unrotatedImage->drawImage(tile, x, y);
+bool Stitcher::updateTileLayer() {
+    // returns whether the layer changed
+    ViewLayout layout = getViewLayout();
+    int width = tileLayer.getWidth();
+    int height = tileLayer.getHeight();
+
+    // scroll the existing content for pans instead of redrawing all tiles
+    int dx = layerOriginX - layout.originX;
+    int dy = layerOriginY - layout.originY;
+    bool redrawAll = !tileLayerValid || page != layerPage || zoomLevel != layerZoom ||
+                     std::abs(dx) >= width || std::abs(dy) >= height;
+
+    if (redrawAll) {
+        layerTiles.clear();
+        dx = dy = 0;
+    } else {
+        tileLayer.scroll(dx, dy);
+    }
+
+    // the strips uncovered by scrolling
+    int exposedX0 = dx > 0 ? 0 : width + dx;
+    int exposedX1 = dx > 0 ? dx : width;
+    int exposedY0 = dy > 0 ? 0 : height + dy;
+    int exposedY1 = dy > 0 ? dy : height;
+
+    bool changed = redrawAll || dx != 0 || dy != 0;
+    std::map<std::pair<int, int>, std::shared_ptr<Image>> visibleTiles;
+
+    forEachTileInView(layout, [&] (int tileX, int tileY, int posX, int posY, std::shared_ptr<Image> tile) {
+        auto key = std::make_pair(tileX, tileY);
+        auto it = layerTiles.find(key);
+        bool replaced = (it == layerTiles.end()) || (it->second != tile);
+
+        bool exposed = redrawAll ||
+                (dx != 0 && posX < exposedX1 && posX + layout.tileWidth > exposedX0) ||
+                (dy != 0 && posY < exposedY1 && posY + layout.tileHeight > exposedY0);
+
+        if (replaced || exposed) {
+            tileLayer.drawImage(*tile, posX, posY);
+            changed = true;
+        }
+
+        visibleTiles[key] = tile;
     });
 
+    layerTiles = std::move(visibleTiles);
+    layerPage = page;
+    layerZoom = zoomLevel;
+    layerOriginX = layout.originX;
+    layerOriginY = layout.originY;
+    tileLayerValid = true;
+
+    return changed;
+}
+
+void Stitcher::composeImage() {
+    const uint32_t *src = tileLayer.getPixels();
+    std::copy(src, src + tileLayer.getWidth() * tileLayer.getHeight(), unrotatedImage->getPixels());
+
     if (onPreRotate) {
         onPreRotate();
     }
 
-    unrotatedImage->rotate(*dstImage, rotAngle);
+    if (unrotatedImage != dstImage) {
+        unrotatedImage->rotateFull(*dstImage, rotAngle);
+    }
 
     if (onRedraw) {
         onRedraw();
     }
 }
 
+void Stitcher::updateImage() {
+    updateTileLayer();
+    composeImage();
+}
+
 void Stitcher::doWork() {
-    if (pendingTiles) {
-        updateImage();
-    } else {
-        // when there is nothing to do, load all tiles from the memory
-        // cache anyways in order to touch the cache time so that
-        // the tiles in sight are not flushed
-        forEachTileInView([] (int x, int y, img::Image &tile) {
-            // do nothing, just touch the cache
-        });
+    // also touches the cache time of the tiles in sight so that they are not flushed
+    if (updateTileLayer()) {
+        composeImage();
     }
 }
 
@@ -20,6 +20,8 @@
 
 #include <memory>
 #include <functional>
+#include <map>
+#include <utility>
 #include "TileSource.h"
 #include "TileCache.h"
 #include "src/libimg/Image.h"
@@ -32,13 +34,20 @@ public:
     using PreRotateCallback = std::function<void(void)>;
 
     Stitcher(std::shared_ptr<Image> dstImage, std::shared_ptr<TileSource> source);
-    void setCacheDirectory(const std::string &utf8Path);
+    void setCacheDirectory(const std::string &utf8Path, size_t rawCacheBytes = 0);
     void setPreRotateCallback(PreRotateCallback cb);
     void setRedrawCallback(RedrawCallback cb);
 
     void setCenter(double x, double y);
     img::Point<double> getCenter() const;
 
+    // Load the tile containing this point before all others, e.g. the one below the aircraft
+    void setPriorityPoint(double x, double y);
+    void clearPriorityPoint();
+
+    // Tiles to fetch into the disk cache while idle, see TileCache::setPrefetchTiles
+    void setPrefetchTiles(const std::vector<TileCache::TileCoords> &tiles);
+
     int getCurrentPage() const;
     int getPageCount() const;
     void nextPage();
@@ -54,13 +63,24 @@ public:
 
     void rotateRight();
 
+    // Has the dimensions of the target image rotated back, it is the target image itself if not rotated
     std::shared_ptr<Image> getPreRotatedImage();
     std::shared_ptr<Image> getTargetImage();
     std::shared_ptr<TileSource> getTileSource();
 
 private:
+    using TileFunction = std::function<void(int tileX, int tileY, int posX, int posY, std::shared_ptr<Image> tile)>;
+
+    struct ViewLayout {
+        int tileWidth, tileHeight;
+        int xOff, yOff; // center pixel's position inside the center tile
+        int centerPosX, centerPosY; // center tile's upper left position in the image
+        int radiusX, radiusY;
+        int originX, originY; // image's upper left position in zoom level pixels
+    };
+
     int page = 0;
-    Image emptyTile, errorTile, loadingTile;
+    std::shared_ptr<Image> emptyTile, errorTile, loadingTile;
     std::shared_ptr<Image> unrotatedImage;
     std::shared_ptr<Image> dstImage;
     std::shared_ptr<TileSource> tileSource;
@@ -69,10 +89,22 @@ private:
     PreRotateCallback onPreRotate;
     int zoomLevel = 0;
     double centerX = 0, centerY = 0;
-    bool pendingTiles = true;
+    bool hasPriorityPoint = false;
+    double priorityX = 0, priorityY = 0;
     int rotAngle = 0;
 
-    void forEachTileInView(std::function<void(int, int, img::Image &)> f);
+    // Only tiles without overlays, so it can be scrolled and patched
+    Image tileLayer;
+    bool tileLayerValid = false;
+    int layerPage = 0, layerZoom = 0;
+    int layerOriginX = 0, layerOriginY = 0;
+    std::map<std::pair<int, int>, std::shared_ptr<Image>> layerTiles;
+
+    ViewLayout getViewLayout();
+    void setupLayers();
+    void forEachTileInView(const ViewLayout &layout, TileFunction f);
+    bool updateTileLayer();
+    void composeImage();
 };
 
 } /* namespace img */
@@ -17,26 +17,82 @@
  */
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <cmath>
 #include "TileCache.h"
+#include "DirectoryTileStore.h"
+#include "TilePack.h"
 #include "src/platform/Platform.h"
 #include "src/platform/CrashHandler.h"
 #include "src/Logger.h"
 
 namespace img {
 
-TileCache::TileCache(std::shared_ptr<TileSource> source):
-    tileSource(source)
+TileCache::TileCache(std::shared_ptr<TileSource> source, int loaderThreads):
+    tileSource(source),
+    lastFlush(std::chrono::steady_clock::now())
 {
-    loaderThread = std::make_unique<std::thread>(&TileCache::loadLoop, this);
+    if (loaderThreads <= 0) {
+        loaderThreads = (int) std::thread::hardware_concurrency() - 1;
+    }
+
+    // disk cache lookups use all threads, but only maxParallelLoads threads
+    // will call into the source at the same time
+    maxParallelLoads = std::max(1, source->getMaxParallelLoads());
+    int numThreads = std::max(1, loaderThreads);
+
+    for (int i = 0; i < numThreads; i++) {
+        this->loaderThreads.emplace_back(&TileCache::loadLoop, this);
+    }
+}
+
+void TileCache::setCacheDirectory(const std::string& utf8Path, size_t rawCacheBytes) {
+    if (!platform::fileExists(utf8Path)) {
+        platform::mkdir(utf8Path);
+    }
+
+    std::shared_ptr<RawTileCache> raw;
+    if (rawCacheBytes > 0) {
+        try {
+            raw = RawTileCache::open(utf8Path, rawCacheBytes);
+        } catch (const std::exception &e) {
+            logger::warn("Raw tile cache disabled: %s", e.what());
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        rawCache = raw;
+    }
+
+    if (TilePack::exists(utf8Path)) {
+        setTileStore(TilePack::open(utf8Path));
+    } else {
+        setTileStore(std::make_shared<DirectoryTileStore>(utf8Path));
+    }
+}
+
+void TileCache::setTileStore(std::shared_ptr<TileStore> store) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    tileStore = store;
 }
 
-void TileCache::setCacheDirectory(const std::string& utf8Path) {
-    cacheDir = utf8Path;
-    if (!platform::fileExists(cacheDir)) {
-        platform::mkdir(cacheDir);
+void TileCache::setMemoryBudget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    memoryBudget = bytes;
+    while (stats.bytesUsed > memoryBudget && !memoryCache.empty()) {
+        evictLeastRecentlyUsed();
     }
 }
 
+TileCache::Statistics TileCache::getStatistics() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    Statistics res = stats;
+    res.entries = memoryCache.size();
+    res.bytesBudget = memoryBudget;
+    return res;
+}
+
 std::shared_ptr<Image> TileCache::getTile(int page, int x, int y, int zoom) {
     if (!tileSource->isTileValid(page, x, y, zoom)) {
         // coords out of bounds: treat as transparent
@@ -56,52 +112,177 @@ std::shared_ptr<Image> TileCache::getTile(int page, int x, int y, int zoom) {
     // Cache strategy: Check memory cache first
     image = getFromMemory(page, x, y, zoom);
     if (image) {
+        stats.hits++;
         return image;
     }
 
-    // Then check file cache
-    image = getFromDisk(page, x, y, zoom);
-    if (image) {
-        return image;
+    // Cache miss -> enqueue and return miss for now. The loader threads
+    // check the disk cache before asking the source so that the caller
+    // never has to wait for file access or image decoding.
+    // Polling a tile that is still loading doesn't count as another miss.
+    if (enqueue(page, x, y, zoom)) {
+        stats.misses++;
     }
-
-    // Finally got a cache miss -> enqueue and return miss for now
-    enqueue(page, x, y, zoom);
     return nullptr;
 }
 
+uint64_t TileCache::packKey(int page, int x, int y, int zoom) {
+    // 16 bits page, 8 bits zoom, 20 bits each for x and y
+    uint64_t key = (uint64_t) (page & 0xFFFF) << 48;
+    key |= (uint64_t) ((zoom + 128) & 0xFF) << 40;
+    key |= (uint64_t) (x & 0xFFFFF) << 20;
+    key |= (uint64_t) (y & 0xFFFFF);
+    return key;
+}
+
 std::shared_ptr<Image> TileCache::getFromMemory(int page, int x, int y, int zoom) {
     // gets called with locked mutex
-    auto it = memoryCache.find(tileSource->getUniqueTileName(page, x, y, zoom));
-    if (it == memoryCache.end()) {
+    auto it = memoryCacheIndex.find(packKey(page, x, y, zoom));
+    if (it == memoryCacheIndex.end()) {
         return nullptr;
     }
 
-    MemCacheEntry &entry = it->second;
-    std::get<1>(entry) = std::chrono::steady_clock::now();
-    return std::get<0>(entry);
+    // move to front
+    memoryCache.splice(memoryCache.begin(), memoryCache, it->second);
+
+    MemCacheEntry &entry = *it->second;
+    entry.lastAccess = std::chrono::steady_clock::now();
+    return entry.image;
 }
 
-std::shared_ptr<Image> TileCache::getFromDisk(int page, int x, int y, int zoom) {
+bool img::TileCache::enqueue(int page, int x, int y, int zoom) {
     // gets called with locked mutex
-    std::string fileName = cacheDir + "/" + tileSource->getUniqueTileName(page, x, y, zoom);
-    if (!platform::fileExists(fileName)) {
-        return nullptr;
+    TileCoords coords(page, x, y, zoom);
+    if (!loadSet.insert(coords).second) {
+        // already queued or being loaded by another thread
+        return false;
+    }
+
+    if (!tileStore) {
+        pushRequest(sourceQueue, coords);
+    } else {
+        pushRequest(diskQueue, coords);
     }
+    cacheCondition.notify_one();
+    return true;
+}
 
-    // upon loading: insert into memory cache for next access
-    auto img = std::make_shared<Image>();
-    img->loadImageFile(fileName);
-    enterMemoryCache(page, x, y, zoom, img);
+void TileCache::pushRequest(std::vector<LoadRequest> &queue, const TileCoords &coords) {
+    // gets called with locked mutex
+    queue.push_back(LoadRequest{coords, getPriority(coords)});
+    std::push_heap(queue.begin(), queue.end());
+}
 
-    return img;
+img::TileCache::TileCoords TileCache::popRequest(std::vector<LoadRequest> &queue) {
+    // gets called with locked mutex and non-empty queue, the tile stays in the loadSet
+    std::pop_heap(queue.begin(), queue.end());
+    TileCoords coords = queue.back().coords;
+    queue.pop_back();
+    return coords;
 }
 
-void img::TileCache::enqueue(int page, int x, int y, int zoom) {
+void TileCache::clearQueue(std::vector<LoadRequest> &queue) {
     // gets called with locked mutex
-    TileCoords coords(page, x, y, zoom);
-    loadSet.insert(coords);
-    cacheCondition.notify_one();
+    for (auto &req: queue) {
+        loadSet.erase(req.coords);
+    }
+    queue.clear();
+}
+
+void TileCache::clearQueue() {
+    // gets called with locked mutex, tiles that are currently being loaded stay in the loadSet
+    clearQueue(diskQueue);
+    clearQueue(sourceQueue);
+    prefetchQueue.clear();
+}
+
+double TileCache::getPriority(const TileCoords& coords) const {
+    // gets called with locked mutex
+    int page = std::get<0>(coords);
+    int x = std::get<1>(coords);
+    int y = std::get<2>(coords);
+    int zoom = std::get<3>(coords);
+
+    if (page != focusPage || zoom != focusZoom) {
+        // still wanted in case the user goes back, but only after everything in view
+        return OTHER_ZOOM_PENALTY + std::abs(zoom - focusZoom);
+    }
+
+    if (hasPriorityPoint && x == (int) std::floor(priorityX) && y == (int) std::floor(priorityY)) {
+        return -1;
+    }
+
+    double dx = x + 0.5 - focusX;
+    double dy = y + 0.5 - focusY;
+    return dx * dx + dy * dy;
+}
+
+bool TileCache::isStale(const TileCoords& coords) const {
+    // gets called with locked mutex
+    int page = std::get<0>(coords);
+    int zoom = std::get<3>(coords);
+    return page != focusPage || std::abs(zoom - focusZoom) > MAX_PENDING_ZOOM_DISTANCE;
+}
+
+void TileCache::reprioritize(std::vector<LoadRequest> &queue) {
+    // gets called with locked mutex
+    std::vector<LoadRequest> newQueue;
+    newQueue.reserve(queue.size());
+
+    for (auto &req: queue) {
+        if (isStale(req.coords)) {
+            loadSet.erase(req.coords);
+            continue;
+        }
+        newQueue.push_back(LoadRequest{req.coords, getPriority(req.coords)});
+    }
+
+    std::make_heap(newQueue.begin(), newQueue.end());
+    queue = std::move(newQueue);
+}
+
+void TileCache::reprioritize() {
+    // gets called with locked mutex
+    reprioritize(diskQueue);
+    reprioritize(sourceQueue);
+}
+
+void TileCache::setViewport(int page, int zoom, double centerX, double centerY) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (page == focusPage && zoom == focusZoom && centerX == focusX && centerY == focusY) {
+        return;
+    }
+
+    if (page != focusPage || zoom != focusZoom) {
+        // failed tiles get another chance when the user comes back to them
+        errorSet.clear();
+    }
+
+    focusPage = page;
+    focusZoom = zoom;
+    focusX = centerX;
+    focusY = centerY;
+    reprioritize();
+}
+
+void TileCache::setPriorityPoint(double x, double y) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (hasPriorityPoint && x == priorityX && y == priorityY) {
+        return;
+    }
+
+    hasPriorityPoint = true;
+    priorityX = x;
+    priorityY = y;
+    reprioritize();
+}
+
+void TileCache::clearPriorityPoint() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (hasPriorityPoint) {
+        hasPriorityPoint = false;
+        reprioritize();
+    }
 }
 
 bool TileCache::hasWork() {
@@ -110,7 +291,38 @@ bool TileCache::hasWork() {
         return true;
     }
 
-    return !loadSet.empty();
+    return !downloadResults.empty() || !diskQueue.empty() || canStartSourceLoad() || canStartPrefetch();
+}
+
+bool TileCache::canStartSourceLoad() {
+    // gets called with locked mutex
+    return !sourceQueue.empty() && (int) (activeSet.size() + prefetchSet.size()) < maxParallelLoads;
+}
+
+bool TileCache::canStartPrefetch() {
+    // gets called with locked mutex, prefetching only uses what the visible tiles leave idle
+    if (prefetchQueue.empty() || !tileStore || !diskQueue.empty() || !sourceQueue.empty()) {
+        return false;
+    }
+
+    int maxPrefetches = std::max(1, maxParallelLoads / 2);
+    return (int) prefetchSet.size() < maxPrefetches &&
+           (int) (activeSet.size() + prefetchSet.size()) < maxParallelLoads;
+}
+
+void TileCache::setPrefetchTiles(const std::vector<TileCoords> &tiles) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    prefetchQueue.clear();
+
+    for (auto &coords: tiles) {
+        bool known = errorSet.count(coords) || loadSet.count(coords) || prefetchSet.count(coords) ||
+                memoryCacheIndex.count(packKey(std::get<0>(coords), std::get<1>(coords), std::get<2>(coords), std::get<3>(coords)));
+        if (!known) {
+            prefetchQueue.push_back(coords);
+        }
+    }
+
+    cacheCondition.notify_one();
 }
 
 void TileCache::loadLoop() {
@@ -120,6 +332,12 @@ void TileCache::loadLoop() {
     while (keepAlive) {
         TileCoords coords;
         bool coordsValid = false;
+        bool fromDisk = false;
+        bool downloaded = false;
+        bool prefetching = false;
+        DownloadResult download;
+        std::shared_ptr<TileStore> store;
+        std::shared_ptr<RawTileCache> raw;
         {
             std::unique_lock<std::mutex> lock(cacheMutex);
             // also wake up each second to flush cache
@@ -129,24 +347,68 @@ void TileCache::loadLoop() {
                 break;
             }
 
-            auto it = loadSet.begin();
-            if (it != loadSet.end()) {
-                coords = *it;
-                loadSet.erase(it);
+            if (!downloadResults.empty()) {
+                // decoding finished downloads also frees their load slots
+                download = std::move(downloadResults.back());
+                downloadResults.pop_back();
+                downloaded = true;
+            } else if (!diskQueue.empty()) {
+                // disk lookups don't use the source, so they are not limited
+                coords = popRequest(diskQueue);
+                store = tileStore;
+                raw = rawCache;
+                fromDisk = true;
+                coordsValid = true;
+            } else if (canStartSourceLoad()) {
+                coords = popRequest(sourceQueue);
+                activeSet.insert(coords);
                 tileSource->resumeLoading();
                 coordsValid = true;
+            } else if (canStartPrefetch()) {
+                coords = prefetchQueue.front();
+                prefetchQueue.pop_front();
+                prefetchSet.insert(coords);
+                store = tileStore;
+                tileSource->resumeLoading();
+                prefetching = true;
             }
         }
 
-        if (coordsValid) {
+        if (downloaded) {
+            finishDownload(download);
+            if (download.prefetch) {
+                finishPrefetch(download.coords);
+            } else {
+                finishSourceLoad(download.coords);
+            }
+        } else if (prefetching) {
+            prefetchTile(store, coords);
+        } else if (coordsValid && fromDisk) {
+            loadFromStore(store, raw, coords);
+        } else if (coordsValid) {
             int page = std::get<0>(coords);
             int x = std::get<1>(coords);
             int y = std::get<2>(coords);
             int zoom = std::get<3>(coords);
-            if (!getFromMemory(page, x, y, zoom)) {
+
+            bool alreadyLoaded;
+            {
+                std::lock_guard<std::mutex> lock(cacheMutex);
+                alreadyLoaded = getFromMemory(page, x, y, zoom) != nullptr;
+            }
+
+            bool downloading = false;
+            if (!alreadyLoaded) {
                 // some sources load multiple x/y/zoom tiles at once, so it could already
-                // be loaded from another pair
-                loadAndCacheTile(page, x, y, zoom);
+                // be loaded from another pair. Downloads keep their slot until finishDownload.
+                downloading = startDownload(coords, false);
+                if (!downloading) {
+                    loadAndCacheTile(page, x, y, zoom);
+                }
+            }
+
+            if (!downloading) {
+                finishSourceLoad(coords);
             }
         }
 
@@ -155,6 +417,45 @@ void TileCache::loadLoop() {
     logger::verbose("TileCache ending thread %d", std::this_thread::get_id());
 }
 
+void TileCache::loadFromStore(std::shared_ptr<TileStore> store, std::shared_ptr<RawTileCache> raw, const TileCoords &coords) {
+    // gets called unlocked
+    int page = std::get<0>(coords);
+    int x = std::get<1>(coords);
+    int y = std::get<2>(coords);
+    int zoom = std::get<3>(coords);
+
+    std::shared_ptr<Image> image;
+    try {
+        std::string name = tileSource->getUniqueTileName(page, x, y, zoom);
+        if (raw) {
+            image = raw->loadTile(name);
+        }
+
+        if (!image && store) {
+            image = store->loadTile(name);
+            if (image && raw) {
+                // decode only once
+                raw->storeTile(name, *image);
+            }
+        }
+    } catch (const std::exception &e) {
+        // corrupt cache file: load it from the source again
+        logger::verbose("Couldn't load cached tile %d/%d/%d: %s", zoom, x, y, e.what());
+    }
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (image) {
+        enterMemoryCache(page, x, y, zoom, image);
+        loadSet.erase(coords);
+    } else if (isStale(coords)) {
+        // the viewport moved on while we were looking
+        loadSet.erase(coords);
+    } else {
+        pushRequest(sourceQueue, coords);
+        cacheCondition.notify_one();
+    }
+}
+
 void TileCache::loadAndCacheTile(int page, int x, int y, int zoom) {
     // gets called unlocked
     std::shared_ptr<Image> image;
@@ -166,52 +467,252 @@ void TileCache::loadAndCacheTile(int page, int x, int y, int zoom) {
     } catch (const std::exception &e) {
         // some error
         logger::verbose("Marking tile %d/%d/%d as error: %s", zoom, x, y, e.what());
+        std::lock_guard<std::mutex> lock(cacheMutex);
         errorSet.insert(TileCoords(page, x, y, zoom));
         return;
     }
 
+    storeLoadedTile(page, x, y, zoom, image);
+}
+
+bool TileCache::startDownload(const TileCoords &coords, bool prefetch) {
+    // gets called unlocked
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        pendingDownloads++;
+    }
+
+    bool started = false;
+    try {
+        started = tileSource->startTileDownload(std::get<0>(coords), std::get<1>(coords), std::get<2>(coords), std::get<3>(coords),
+            [this, coords, prefetch] (std::vector<uint8_t> data, std::exception_ptr error) {
+                // called from the download thread, maybe even before startTileDownload returned
+                std::lock_guard<std::mutex> lock(cacheMutex);
+                downloadResults.push_back(DownloadResult{coords, std::move(data), error, prefetch});
+                pendingDownloads--;
+                cacheCondition.notify_all();
+            });
+    } catch (const std::exception &e) {
+        // loadTileImage will run into the same error and mark the tile
+        started = false;
+    }
+
+    if (!started) {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        pendingDownloads--;
+        cacheCondition.notify_all();
+    }
+
+    return started;
+}
+
+void TileCache::finishDownload(DownloadResult &result) {
+    // gets called unlocked
+    int page = std::get<0>(result.coords);
+    int x = std::get<1>(result.coords);
+    int y = std::get<2>(result.coords);
+    int zoom = std::get<3>(result.coords);
+
+    std::shared_ptr<Image> image;
+    try {
+        if (result.error) {
+            std::rethrow_exception(result.error);
+        }
+        image = tileSource->decodeTileData(page, x, y, zoom, result.data);
+    } catch (const std::out_of_range &e) {
+        // cancelled
+        return;
+    } catch (const std::exception &e) {
+        if (result.prefetch) {
+            // it gets another chance once it is visible
+            return;
+        }
+        logger::verbose("Marking tile %d/%d/%d as error: %s", zoom, x, y, e.what());
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        errorSet.insert(result.coords);
+        return;
+    }
+
+    if (result.prefetch) {
+        storePrefetchedTile(result.coords, *image);
+    } else {
+        storeLoadedTile(page, x, y, zoom, image);
+    }
+}
+
+void TileCache::prefetchTile(std::shared_ptr<TileStore> store, const TileCoords &coords) {
+    // gets called unlocked
+    bool downloading = false;
+    try {
+        std::string name = tileSource->getUniqueTileName(std::get<0>(coords), std::get<1>(coords), std::get<2>(coords), std::get<3>(coords));
+        if (store && !store->hasTile(name)) {
+            downloading = startDownload(coords, true);
+            if (!downloading) {
+                auto image = tileSource->loadTileImage(std::get<0>(coords), std::get<1>(coords), std::get<2>(coords), std::get<3>(coords));
+                storePrefetchedTile(coords, *image);
+            }
+        }
+    } catch (const std::exception &e) {
+        // cancelled or failed, it gets another chance once it is visible
+    }
+
+    if (!downloading) {
+        finishPrefetch(coords);
+    }
+}
+
+void TileCache::storePrefetchedTile(const TileCoords &coords, Image &image) {
+    // gets called unlocked
+    std::shared_ptr<TileStore> store;
+    std::shared_ptr<RawTileCache> raw;
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        store = tileStore;
+        raw = rawCache;
+    }
+
+    if (!store) {
+        return;
+    }
+
+    try {
+        std::string name = tileSource->getUniqueTileName(std::get<0>(coords), std::get<1>(coords), std::get<2>(coords), std::get<3>(coords));
+        if (!store->hasTile(name)) {
+            store->storeTile(name, image);
+            if (raw) {
+                raw->removeTile(name);
+            }
+        }
+    } catch (const std::exception &e) {
+        logger::warn("Couldn't store prefetched tile: %s", e.what());
+    }
+}
+
+void TileCache::finishPrefetch(const TileCoords &coords) {
+    // gets called unlocked
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        prefetchSet.erase(coords);
+    }
+    cacheCondition.notify_one();
+}
+
+void TileCache::finishSourceLoad(const TileCoords &coords) {
+    // gets called unlocked
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        activeSet.erase(coords);
+        loadSet.erase(coords);
+    }
+    // a load slot became available
+    cacheCondition.notify_one();
+}
+
+void TileCache::storeLoadedTile(int page, int x, int y, int zoom, std::shared_ptr<Image> image) {
+    // gets called unlocked
     std::string fileName = tileSource->getUniqueTileName(page, x, y, zoom);
 
-    std::lock_guard<std::mutex> lock(cacheMutex);
-    enterMemoryCache(page, x, y, zoom, image);
-    image->storeAndClearEncodedData(cacheDir + "/" + fileName);
+    std::shared_ptr<TileStore> store;
+    std::shared_ptr<RawTileCache> raw;
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        enterMemoryCache(page, x, y, zoom, image);
+        store = tileStore;
+        raw = rawCache;
+    }
+
+    if (!store) {
+        return;
+    }
+
+    // the image is already visible, so write the tile without blocking getTile
+    try {
+        store->storeTile(fileName, *image);
+        if (raw) {
+            // the decoded copy is of the old version, it is filled again on the next load
+            raw->removeTile(fileName);
+        }
+    } catch (const std::exception &e) {
+        logger::warn("Couldn't store tile %d/%d/%d: %s", zoom, x, y, e.what());
+    }
 }
 
 void TileCache::enterMemoryCache(int page, int x, int y, int zoom, std::shared_ptr<Image> img) {
     // gets called with locked mutex
-    auto timeStamp = std::chrono::steady_clock::now();
-    MemCacheEntry entry(img, timeStamp);
-    memoryCache.insert(std::make_pair(tileSource->getUniqueTileName(page, x, y, zoom), entry));
+    uint64_t key = packKey(page, x, y, zoom);
+    if (memoryCacheIndex.find(key) != memoryCacheIndex.end()) {
+        return;
+    }
+
+    MemCacheEntry entry;
+    entry.key = key;
+    entry.image = img;
+    entry.bytes = img->getWidth() * img->getHeight() * sizeof(uint32_t);
+    entry.lastAccess = std::chrono::steady_clock::now();
+
+    memoryCache.push_front(entry);
+    memoryCacheIndex[key] = memoryCache.begin();
+    stats.bytesUsed += entry.bytes;
+
+    // always keep the newest tile even if it alone exceeds the budget
+    while (stats.bytesUsed > memoryBudget && memoryCache.size() > 1) {
+        evictLeastRecentlyUsed();
+    }
 }
 
-void TileCache::cancelPendingRequests() {
-    std::lock_guard<std::mutex> lock(cacheMutex);
-    tileSource->cancelPendingLoads();
-    errorSet.clear();
-    loadSet.clear();
+void TileCache::evictLeastRecentlyUsed() {
+    // gets called with locked mutex and non-empty cache
+    MemCacheEntry &entry = memoryCache.back();
+    stats.bytesUsed -= entry.bytes;
+    stats.evictions++;
+    memoryCacheIndex.erase(entry.key);
+    memoryCache.pop_back();
+}
+
+void TileCache::clearMemoryCache() {
+    // gets called with locked mutex
+    memoryCache.clear();
+    memoryCacheIndex.clear();
+    stats.bytesUsed = 0;
 }
 
 void TileCache::flushCache() {
     // gets called unlocked
     std::lock_guard<std::mutex> lock(cacheMutex);
     auto now = std::chrono::steady_clock::now();
-    for (auto it = memoryCache.begin(); it != memoryCache.end(); ) {
-        auto diff = now - std::get<1>(it->second);
-        if (std::chrono::duration_cast<std::chrono::seconds>(diff).count() >= CACHE_SECONDS) {
-            it = memoryCache.erase(it);
-        } else {
-            ++it;
+
+    // all loader threads call this, but one flush per second is enough
+    if (now - lastFlush < std::chrono::seconds(1)) {
+        return;
+    }
+    lastFlush = now;
+
+    // the list is ordered by access time, so only the tail needs to be checked
+    while (!memoryCache.empty()) {
+        auto diff = now - memoryCache.back().lastAccess;
+        if (std::chrono::duration_cast<std::chrono::seconds>(diff).count() < CACHE_SECONDS) {
+            break;
         }
+        evictLeastRecentlyUsed();
     }
 }
 
 void TileCache::invalidate() {
     // gets called unlocked
-    std::lock_guard<std::mutex> lock(cacheMutex);
-    tileSource->cancelPendingLoads();
-    memoryCache.clear();
-    errorSet.clear();
-    loadSet.clear();
+    std::shared_ptr<RawTileCache> raw;
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        tileSource->cancelPendingLoads();
+        clearMemoryCache();
+        errorSet.clear();
+        clearQueue();
+        raw = rawCache;
+    }
+
+    // we don't know which of its tiles belong to our source
+    if (raw) {
+        raw->clear();
+    }
 }
 
 TileCache::~TileCache() {
@@ -219,9 +720,23 @@ TileCache::~TileCache() {
         std::lock_guard<std::mutex> lock(cacheMutex);
         keepAlive = false;
         tileSource->cancelPendingLoads();
-        cacheCondition.notify_one();
+        cacheCondition.notify_all();
     }
-    loaderThread->join();
+
+    for (auto &thread: loaderThreads) {
+        thread.join();
+    }
+
+    {
+        // pending downloads call back into this object. Cancel again in case a
+        // loader thread resumed the source while we were shutting down.
+        std::unique_lock<std::mutex> lock(cacheMutex);
+        tileSource->cancelPendingLoads();
+        cacheCondition.wait(lock, [this] () { return pendingDownloads == 0; });
+    }
+
+    logger::verbose("TileCache stats: %llu hits, %llu misses, %llu evictions",
+            (unsigned long long) stats.hits, (unsigned long long) stats.misses, (unsigned long long) stats.evictions);
 }
 
 } /* namespace img */
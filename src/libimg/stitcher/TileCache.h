@@ -21,55 +21,158 @@
 #include <cstdint>
 #include <string>
 #include <map>
+#include <list>
+#include <deque>
+#include <unordered_map>
 #include <memory>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
 #include <set>
+#include <vector>
 #include <tuple>
 #include <chrono>
+#include <exception>
 #include "TileSource.h"
+#include "TileStore.h"
+#include "RawTileCache.h"
 
 namespace img {
 
 class TileCache {
 public:
-    TileCache(std::shared_ptr<TileSource> source);
-    void setCacheDirectory(const std::string &utf8Path);
+    using TileCoords = std::tuple<int, int, int, int>; // page, x, y, zoom
+
+    struct Statistics {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        size_t entries = 0;
+        size_t bytesUsed = 0;
+        size_t bytesBudget = 0;
+    };
+
+    // loaderThreads <= 0 uses one thread less than there are CPU cores.
+    // getTile never blocks on I/O: disk cache hits are also decoded by the loader threads.
+    TileCache(std::shared_ptr<TileSource> source, int loaderThreads = 0);
+
+    // Uses the tile pack in this directory if there is one, otherwise one file per tile.
+    // If rawCacheBytes is not zero, tiles read from the store are also kept decoded.
+    void setCacheDirectory(const std::string &utf8Path, size_t rawCacheBytes = 0);
+    void setTileStore(std::shared_ptr<TileStore> store);
+    void setMemoryBudget(size_t bytes);
+    Statistics getStatistics();
     std::shared_ptr<Image> getTile(int page, int x, int y, int zoom);
-    void cancelPendingRequests();
+
+    // Pending tiles closest to the viewport center are loaded first,
+    // requests for other pages or distant zoom levels are dropped.
+    // Changing the page or zoom level retries tiles that failed to load.
+    void setViewport(int page, int zoom, double centerX, double centerY);
+
+    // The tile containing this point (in tile coordinates of the viewport zoom) is always loaded first
+    void setPriorityPoint(double x, double y);
+    void clearPriorityPoint();
+
+    // Replaces the tiles to fetch into the tile store while the loaders are idle, most important first.
+    // Prefetched tiles don't enter the memory cache. Does nothing without a tile store.
+    void setPrefetchTiles(const std::vector<TileCoords> &tiles);
+
     void invalidate();
     ~TileCache();
 private:
     static constexpr const int CACHE_SECONDS = 30;
+    static constexpr const size_t DEFAULT_MEMORY_BUDGET = 128 * 1024 * 1024;
+    static constexpr const int MAX_PENDING_ZOOM_DISTANCE = 1;
+    static constexpr const double OTHER_ZOOM_PENALTY = 1e6;
     using TimeStamp = std::chrono::time_point<std::chrono::steady_clock>;
-    using TileCoords = std::tuple<int, int, int, int>;
-    using MemCacheEntry = std::tuple<std::shared_ptr<Image>, TimeStamp>;
+
+    struct MemCacheEntry {
+        uint64_t key;
+        std::shared_ptr<Image> image;
+        size_t bytes;
+        TimeStamp lastAccess;
+    };
+    using MemCacheList = std::list<MemCacheEntry>;
+
+    struct LoadRequest {
+        TileCoords coords;
+        double priority; // lower values are loaded first
+
+        // inverted so that the std heap functions put the lowest priority value on top
+        bool operator<(const LoadRequest &other) const { return priority > other.priority; }
+    };
+
+    struct DownloadResult {
+        TileCoords coords;
+        std::vector<uint8_t> data;
+        std::exception_ptr error;
+        bool prefetch;
+    };
 
     std::shared_ptr<TileSource> tileSource;
-    std::string cacheDir;
-    std::unique_ptr<std::thread> loaderThread;
+    std::shared_ptr<TileStore> tileStore;
+    std::shared_ptr<RawTileCache> rawCache;
+    std::vector<std::thread> loaderThreads;
+    int maxParallelLoads = 1;
 
     std::shared_ptr<Image> errorTile;
 
     std::mutex cacheMutex;
     std::condition_variable cacheCondition;
-    std::map<std::string, MemCacheEntry> memoryCache;
-    std::set<TileCoords> loadSet;
+
+    // most recently used tiles at the front
+    MemCacheList memoryCache;
+    std::unordered_map<uint64_t, MemCacheList::iterator> memoryCacheIndex;
+    size_t memoryBudget = DEFAULT_MEMORY_BUDGET;
+    Statistics stats;
+    std::vector<LoadRequest> diskQueue; // binary heap of tiles to look up in the disk cache
+    std::vector<LoadRequest> sourceQueue; // binary heap of tiles to load from the source
+    std::set<TileCoords> loadSet; // all tiles that are queued or being loaded
     std::set<TileCoords> errorSet;
+    std::set<TileCoords> activeSet; // tiles being loaded from the source
+    std::vector<DownloadResult> downloadResults; // finished asynchronous downloads, still to be decoded
+    int pendingDownloads = 0; // asynchronous downloads that didn't call back yet
+    std::deque<TileCoords> prefetchQueue;
+    std::set<TileCoords> prefetchSet; // tiles being prefetched
+    TimeStamp lastFlush;
+
+    int focusPage = 0, focusZoom = 0;
+    double focusX = 0, focusY = 0;
+    bool hasPriorityPoint = false;
+    double priorityX = 0, priorityY = 0;
 
     std::atomic_bool keepAlive { true };
 
+    static uint64_t packKey(int page, int x, int y, int zoom);
     std::shared_ptr<Image> getFromMemory(int page, int x, int y, int zoom);
-    std::shared_ptr<Image> getFromDisk(int page, int x, int y, int zoom);
-    void enqueue(int page, int x, int y, int zoom);
+    bool enqueue(int page, int x, int y, int zoom);
+    double getPriority(const TileCoords &coords) const;
+    bool isStale(const TileCoords &coords) const;
+    void pushRequest(std::vector<LoadRequest> &queue, const TileCoords &coords);
+    TileCoords popRequest(std::vector<LoadRequest> &queue);
+    void reprioritize(std::vector<LoadRequest> &queue);
+    void reprioritize();
+    void clearQueue(std::vector<LoadRequest> &queue);
+    void clearQueue();
 
     void loadLoop();
     bool hasWork();
+    bool canStartSourceLoad();
+    bool canStartPrefetch();
     void flushCache();
+    void loadFromStore(std::shared_ptr<TileStore> store, std::shared_ptr<RawTileCache> raw, const TileCoords &coords);
     void loadAndCacheTile(int page, int x, int y, int zoom);
+    bool startDownload(const TileCoords &coords, bool prefetch);
+    void finishDownload(DownloadResult &result);
+    void finishSourceLoad(const TileCoords &coords);
+    void storeLoadedTile(int page, int x, int y, int zoom, std::shared_ptr<Image> image);
+    void prefetchTile(std::shared_ptr<TileStore> store, const TileCoords &coords);
+    void storePrefetchedTile(const TileCoords &coords, Image &image);
+    void finishPrefetch(const TileCoords &coords);
     void enterMemoryCache(int page, int x, int y, int zoom, std::shared_ptr<Image> img);
+    void evictLeastRecentlyUsed();
+    void clearMemoryCache();
 };
 
 } /* namespace img */
@@ -0,0 +1,350 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <map>
+#include <cstring>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+#include "TilePack.h"
+#include "src/Logger.h"
+
+namespace img {
+
+namespace {
+
+void writeU32(std::ostream &out, uint32_t v) {
+    uint8_t buf[4] = {uint8_t(v), uint8_t(v >> 8), uint8_t(v >> 16), uint8_t(v >> 24)};
+    out.write(reinterpret_cast<const char *>(buf), sizeof(buf));
+}
+
+void writeU64(std::ostream &out, uint64_t v) {
+    writeU32(out, v & 0xFFFFFFFF);
+    writeU32(out, v >> 32);
+}
+
+uint32_t readU32(const uint8_t *buf) {
+    return buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((uint32_t) buf[3] << 24);
+}
+
+uint64_t readU64(const uint8_t *buf) {
+    return readU32(buf) | ((uint64_t) readU32(buf + 4) << 32);
+}
+
+}
+
+std::shared_ptr<TilePack> TilePack::open(const std::string& utf8Dir) {
+    static std::mutex registryMutex;
+    static std::map<std::string, std::weak_ptr<TilePack>> registry;
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto pack = registry[utf8Dir].lock();
+    if (!pack) {
+        pack = std::make_shared<TilePack>(utf8Dir);
+        registry[utf8Dir] = pack;
+    }
+    return pack;
+}
+
+bool TilePack::exists(const std::string& utf8Dir) {
+    return platform::fileExists(utf8Dir + "/" + PACK_FILE_NAME);
+}
+
+TilePack::TilePack(const std::string& utf8Dir):
+    packPath(utf8Dir + "/" + PACK_FILE_NAME),
+    indexPath(utf8Dir + "/" + INDEX_FILE_NAME)
+{
+    if (!platform::fileExists(packPath)) {
+        createPack();
+    }
+
+    packSize = fs::file_size(fs::u8path(packPath));
+
+    bool indexValid = loadIndex();
+
+    // recover records that were written after the last index entry
+    uint64_t indexEnd = FILE_HEADER_SIZE;
+    for (auto &it: index) {
+        indexEnd = std::max(indexEnd, it.second.offset + RECORD_HEADER_SIZE + it.second.nameLen + it.second.dataLen);
+    }
+
+    size_t numIndexed = index.size();
+    uint64_t validEnd = scanPack(indexEnd);
+    if (validEnd < packSize) {
+        logger::warn("Truncating incomplete tile record in %s", packPath.c_str());
+        fs::resize_file(fs::u8path(packPath), validEnd);
+        packSize = validEnd;
+    }
+
+    if (!indexValid || index.size() != numIndexed) {
+        writeIndex();
+    }
+
+    packFile = std::make_unique<platform::RandomAccessFile>(packPath);
+    indexFile.open(fs::u8path(indexPath), std::ios::out | std::ios::app | std::ios::binary);
+    if (!indexFile) {
+        throw std::runtime_error("Couldn't open tile pack index " + indexPath);
+    }
+
+    logger::verbose("Opened tile pack %s with %d tiles", packPath.c_str(), (int) index.size());
+}
+
+void TilePack::createPack() {
+    fs::ofstream out(fs::u8path(packPath), std::ios::out | std::ios::binary);
+    writeU32(out, PACK_MAGIC);
+    writeU32(out, VERSION);
+    if (!out) {
+        throw std::runtime_error("Couldn't create tile pack " + packPath);
+    }
+}
+
+bool TilePack::loadIndex() {
+    fs::ifstream in(fs::u8path(indexPath), std::ios::in | std::ios::binary);
+    if (!in) {
+        return false;
+    }
+
+    std::vector<uint8_t> buf((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (buf.size() < FILE_HEADER_SIZE || readU32(&buf[0]) != INDEX_MAGIC || readU32(&buf[4]) != VERSION) {
+        return false;
+    }
+
+    constexpr size_t entrySize = 24;
+    for (size_t pos = FILE_HEADER_SIZE; pos + entrySize <= buf.size(); pos += entrySize) {
+        uint64_t hash = readU64(&buf[pos]);
+        IndexEntry entry;
+        entry.offset = readU64(&buf[pos + 8]);
+        entry.nameLen = readU32(&buf[pos + 16]);
+        entry.dataLen = readU32(&buf[pos + 20]);
+
+        if (entry.offset < FILE_HEADER_SIZE || entry.offset + RECORD_HEADER_SIZE + entry.nameLen + entry.dataLen > packSize) {
+            // the pack was truncated behind our back
+            return false;
+        }
+
+        index[hash] = entry;
+    }
+
+    return true;
+}
+
+uint64_t TilePack::scanPack(uint64_t offset) {
+    // returns the end of the last complete record
+    fs::ifstream in(fs::u8path(packPath), std::ios::in | std::ios::binary);
+
+    uint8_t header[FILE_HEADER_SIZE];
+    in.read(reinterpret_cast<char *>(header), sizeof(header));
+    if (!in || readU32(header) != PACK_MAGIC || readU32(header + 4) != VERSION) {
+        throw std::runtime_error("Invalid tile pack " + packPath);
+    }
+
+    std::string name;
+    while (offset + RECORD_HEADER_SIZE <= packSize) {
+        uint8_t recHeader[RECORD_HEADER_SIZE];
+        in.seekg(offset);
+        in.read(reinterpret_cast<char *>(recHeader), sizeof(recHeader));
+        if (!in || readU32(recHeader) != RECORD_MAGIC) {
+            break;
+        }
+
+        IndexEntry entry;
+        entry.offset = offset;
+        entry.nameLen = readU32(recHeader + 4);
+        entry.dataLen = readU32(recHeader + 8);
+
+        uint64_t end = offset + RECORD_HEADER_SIZE + entry.nameLen + entry.dataLen;
+        if (end > packSize) {
+            break;
+        }
+
+        name.resize(entry.nameLen);
+        in.read(&name[0], entry.nameLen);
+        if (!in) {
+            break;
+        }
+
+        index[hashName(name)] = entry;
+        offset = end;
+    }
+
+    return offset;
+}
+
+void TilePack::writeIndex() {
+    fs::ofstream out(fs::u8path(indexPath), std::ios::out | std::ios::trunc | std::ios::binary);
+    writeU32(out, INDEX_MAGIC);
+    writeU32(out, VERSION);
+    for (auto &it: index) {
+        appendIndexEntry(out, it.first, it.second);
+    }
+}
+
+void TilePack::appendIndexEntry(std::ostream& out, uint64_t hash, const IndexEntry& entry) {
+    writeU64(out, hash);
+    writeU64(out, entry.offset);
+    writeU32(out, entry.nameLen);
+    writeU32(out, entry.dataLen);
+}
+
+std::string TilePack::normalizeName(const std::string& name) {
+    // some sources use names with a leading slash
+    size_t start = name.find_first_not_of('/');
+    if (start == std::string::npos) {
+        return "";
+    }
+    return name.substr(start);
+}
+
+uint64_t TilePack::hashName(const std::string& name) {
+    return platform::hashBytes(name.data(), name.size());
+}
+
+std::shared_ptr<Image> TilePack::loadTile(const std::string& name) {
+    std::vector<uint8_t> data;
+    if (!readTile(name, data)) {
+        return nullptr;
+    }
+
+    auto img = std::make_shared<Image>();
+    img->loadEncodedData(data, false);
+    return img;
+}
+
+void TilePack::storeTile(const std::string& name, Image& image) {
+    auto data = image.takeEncodedData();
+    if (data.empty()) {
+        return;
+    }
+    writeTile(name, data);
+}
+
+bool TilePack::hasTile(const std::string& name) {
+    std::lock_guard<std::mutex> lock(packMutex);
+    return index.find(hashName(normalizeName(name))) != index.end();
+}
+
+bool TilePack::readTile(const std::string& name, std::vector<uint8_t>& data) {
+    std::string key = normalizeName(name);
+
+    IndexEntry entry;
+    {
+        std::lock_guard<std::mutex> lock(packMutex);
+        auto it = index.find(hashName(key));
+        if (it == index.end()) {
+            return false;
+        }
+        entry = it->second;
+    }
+
+    // indexed records are complete and never change, so the loader threads can read in parallel
+    std::string storedName(entry.nameLen, '\0');
+    if (!packFile->readAt(entry.offset + RECORD_HEADER_SIZE, &storedName[0], entry.nameLen) || storedName != key) {
+        // hash collision or I/O error: treat as miss
+        return false;
+    }
+
+    data.resize(entry.dataLen);
+    return packFile->readAt(entry.offset + RECORD_HEADER_SIZE + entry.nameLen, data.data(), entry.dataLen);
+}
+
+void TilePack::writeTile(const std::string& name, const std::vector<uint8_t>& data) {
+    std::string key = normalizeName(name);
+
+    IndexEntry entry;
+    entry.nameLen = key.size();
+    entry.dataLen = data.size();
+
+    std::ostringstream record;
+    writeU32(record, RECORD_MAGIC);
+    writeU32(record, entry.nameLen);
+    writeU32(record, entry.dataLen);
+    record.write(key.data(), key.size());
+    record.write(reinterpret_cast<const char *>(data.data()), data.size());
+    std::string recordData = record.str();
+
+    std::lock_guard<std::mutex> lock(packMutex);
+
+    entry.offset = packSize;
+    packFile->writeAt(entry.offset, recordData.data(), recordData.size());
+
+    // only index the record once it is complete
+    uint64_t hash = hashName(key);
+    packSize += RECORD_HEADER_SIZE + entry.nameLen + entry.dataLen;
+    index[hash] = entry;
+    appendIndexEntry(indexFile, hash, entry);
+    indexFile.flush();
+}
+
+size_t TilePack::getTileCount() {
+    std::lock_guard<std::mutex> lock(packMutex);
+    return index.size();
+}
+
+uint64_t TilePack::compact(const std::string& utf8Dir) {
+    // opening the pack also repairs its index
+    TilePack pack(utf8Dir);
+    std::string tmpPath = pack.packPath + ".tmp";
+
+    // copy in pack order so that the old pack is read front to back
+    std::vector<std::pair<uint64_t, IndexEntry>> entries(pack.index.begin(), pack.index.end());
+    std::sort(entries.begin(), entries.end(), [] (const auto &a, const auto &b) {
+        return a.second.offset < b.second.offset;
+    });
+
+    std::unordered_map<uint64_t, IndexEntry> newIndex;
+    uint64_t newSize = FILE_HEADER_SIZE;
+    {
+        fs::ofstream out(fs::u8path(tmpPath), std::ios::out | std::ios::trunc | std::ios::binary);
+        writeU32(out, PACK_MAGIC);
+        writeU32(out, VERSION);
+
+        std::vector<uint8_t> record;
+        for (auto &it: entries) {
+            IndexEntry entry = it.second;
+            record.resize(RECORD_HEADER_SIZE + entry.nameLen + entry.dataLen);
+            if (!pack.packFile->readAt(entry.offset, record.data(), record.size())) {
+                throw std::runtime_error("Couldn't read tile pack " + pack.packPath);
+            }
+            out.write(reinterpret_cast<const char *>(record.data()), record.size());
+
+            entry.offset = newSize;
+            newIndex[it.first] = entry;
+            newSize += record.size();
+        }
+
+        out.close();
+        if (!out) {
+            fs::remove(fs::u8path(tmpPath));
+            throw std::runtime_error("Couldn't write tile pack " + tmpPath);
+        }
+    }
+
+    uint64_t oldSize = pack.packSize;
+    pack.packFile.reset();
+    pack.indexFile.close();
+
+    // without an index the pack is rescanned on the next start, so a crash in between loses nothing
+    fs::remove(fs::u8path(pack.indexPath));
+    fs::rename(fs::u8path(tmpPath), fs::u8path(pack.packPath));
+    pack.index = std::move(newIndex);
+    pack.packSize = newSize;
+    pack.writeIndex();
+
+    return oldSize - newSize;
+}
+
+} /* namespace img */
@@ -0,0 +1,106 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SRC_LIBIMG_STITCHER_TILEPACK_H_
+#define SRC_LIBIMG_STITCHER_TILEPACK_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include "TileStore.h"
+#include "src/platform/Platform.h"
+#include "src/platform/RandomAccessFile.h"
+
+namespace img {
+
+/*
+ * Stores all tiles of a cache directory in a single append-only file
+ * instead of one file per tile. A separate index file maps the hashed
+ * tile names to their offsets so that opening the pack doesn't need to
+ * scan all tiles. If the index is missing or lags behind the pack after
+ * a crash, it is rebuilt from the pack.
+ *
+ * Pack file:  "AVTP", u32 version, then records of
+ *             u32 "AVTR", u32 nameLen, u32 dataLen, name, encoded image
+ * Index file: "AVTI", u32 version, then entries of
+ *             u64 nameHash, u64 recordOffset, u32 nameLen, u32 dataLen
+ *
+ * All integers are little endian. Updated tiles are appended, the newest
+ * record of a name wins. Records are never modified once they are indexed,
+ * so they are read without holding the pack lock. compact() drops the
+ * superseded records.
+ */
+class TilePack: public TileStore {
+public:
+    static constexpr const char *PACK_FILE_NAME = "tiles.pack";
+    static constexpr const char *INDEX_FILE_NAME = "tiles.idx";
+
+    // Caches using the same directory share the same pack
+    static std::shared_ptr<TilePack> open(const std::string &utf8Dir);
+    static bool exists(const std::string &utf8Dir);
+
+    // Rewrites the pack without superseded records and returns the number of bytes saved.
+    // The pack must not be open anywhere else while this runs.
+    static uint64_t compact(const std::string &utf8Dir);
+
+    TilePack(const std::string &utf8Dir);
+
+    std::shared_ptr<Image> loadTile(const std::string &name) override;
+    void storeTile(const std::string &name, Image &image) override;
+
+    bool hasTile(const std::string &name) override;
+    bool readTile(const std::string &name, std::vector<uint8_t> &data);
+    void writeTile(const std::string &name, const std::vector<uint8_t> &data);
+    size_t getTileCount();
+
+private:
+    static constexpr const uint32_t PACK_MAGIC = 0x50545641; // "AVTP"
+    static constexpr const uint32_t RECORD_MAGIC = 0x52545641; // "AVTR"
+    static constexpr const uint32_t INDEX_MAGIC = 0x49545641; // "AVTI"
+    static constexpr const uint32_t VERSION = 1;
+    static constexpr const uint64_t FILE_HEADER_SIZE = 8;
+    static constexpr const uint64_t RECORD_HEADER_SIZE = 12;
+
+    struct IndexEntry {
+        uint64_t offset;
+        uint32_t nameLen;
+        uint32_t dataLen;
+    };
+
+    std::string packPath, indexPath;
+    std::mutex packMutex; // protects the index and appending to the pack
+    std::unique_ptr<platform::RandomAccessFile> packFile;
+    fs::ofstream indexFile;
+    uint64_t packSize = 0;
+    std::unordered_map<uint64_t, IndexEntry> index;
+
+    static std::string normalizeName(const std::string &name);
+    static uint64_t hashName(const std::string &name);
+
+    void createPack();
+    bool loadIndex();
+    uint64_t scanPack(uint64_t offset);
+    void writeIndex();
+    void appendIndexEntry(std::ostream &out, uint64_t hash, const IndexEntry &entry);
+};
+
+} /* namespace img */
+
+#endif /* SRC_LIBIMG_STITCHER_TILEPACK_H_ */
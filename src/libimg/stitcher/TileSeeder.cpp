@@ -0,0 +1,274 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include "TileSeeder.h"
+#include "TilePack.h"
+#include "DirectoryTileStore.h"
+#include "src/Logger.h"
+#include "src/platform/Platform.h"
+
+namespace img {
+
+double TileSeeder::Progress::getTilesPerSecond() const {
+    if (seconds <= 0) {
+        return 0;
+    }
+    return stored / seconds;
+}
+
+TileSeeder::TileSeeder(std::shared_ptr<TileSource> source, const std::string &utf8CacheDir):
+    tileSource(source)
+{
+    if (!tileSource->supportsSeeding()) {
+        throw std::runtime_error("This map can't be stored for offline use");
+    }
+
+    if (!platform::fileExists(utf8CacheDir)) {
+        platform::mkdir(utf8CacheDir);
+    }
+
+    if (TilePack::exists(utf8CacheDir)) {
+        tileStore = TilePack::open(utf8CacheDir);
+    } else {
+        tileStore = std::make_shared<DirectoryTileStore>(utf8CacheDir);
+    }
+}
+
+void TileSeeder::addArea(int page, Point<double> topLeft, Point<double> bottomRight, int zoom, int minZoom, int maxZoom) {
+    clampZoom(minZoom, maxZoom);
+
+    for (int z = minZoom; z <= maxZoom; z++) {
+        auto p1 = tileSource->transformZoomedPoint(page, topLeft.x, topLeft.y, zoom, z);
+        auto p2 = tileSource->transformZoomedPoint(page, bottomRight.x, bottomRight.y, zoom, z);
+
+        int x1 = std::floor(std::min(p1.x, p2.x));
+        int x2 = std::floor(std::max(p1.x, p2.x));
+        int y1 = std::floor(std::min(p1.y, p2.y));
+        int y2 = std::floor(std::max(p1.y, p2.y));
+        for (int y = y1; y <= y2; y++) {
+            for (int x = x1; x <= x2; x++) {
+                addTile(page, x, y, z);
+            }
+        }
+    }
+}
+
+void TileSeeder::addWorldArea(int page, Point<double> corner1, Point<double> corner2, int minZoom, int maxZoom) {
+    if (!tileSource->supportsWorldCoords()) {
+        throw std::runtime_error("Map has no world coordinates");
+    }
+
+    clampZoom(minZoom, maxZoom);
+
+    for (int z = minZoom; z <= maxZoom; z++) {
+        auto p1 = tileSource->worldToXY(corner1.x, corner1.y, z);
+        auto p2 = tileSource->worldToXY(corner2.x, corner2.y, z);
+        addArea(page, p1, p2, z, z, z);
+    }
+}
+
+void TileSeeder::addWorldPath(int page, const std::vector<Point<double>> &path, int minZoom, int maxZoom) {
+    if (!tileSource->supportsWorldCoords()) {
+        throw std::runtime_error("Map has no world coordinates");
+    }
+
+    if (path.empty()) {
+        return;
+    }
+
+    clampZoom(minZoom, maxZoom);
+
+    // legs that cross the antimeridian are split there, otherwise they would span the whole map
+    std::vector<double> lon, lat;
+    auto addLeg = [&lon, &lat] (double lon1, double lat1, double lon2, double lat2) {
+        lon.insert(lon.end(), {lon1, lon2});
+        lat.insert(lat.end(), {lat1, lat2});
+    };
+
+    addLeg(path[0].x, path[0].y, path[0].x, path[0].y);
+    for (size_t i = 1; i < path.size(); i++) {
+        const Point<double> &from = path[i - 1];
+        const Point<double> &to = path[i];
+        double dLon = to.x - from.x;
+        if (std::abs(dLon) <= 180) {
+            addLeg(from.x, from.y, to.x, to.y);
+            continue;
+        }
+
+        double edge = (dLon > 0) ? -180 : 180;
+        double unwrappedLon = to.x + ((dLon > 0) ? -360 : 360);
+        double t = (edge - from.x) / (unwrappedLon - from.x);
+        double edgeLat = from.y + t * (to.y - from.y);
+        addLeg(from.x, from.y, edge, edgeLat);
+        addLeg(-edge, edgeLat, to.x, to.y);
+    }
+
+    for (int z = minZoom; z <= maxZoom; z++) {
+        std::vector<double> x(lon.size()), y(lat.size());
+        tileSource->worldToXYBatch(lon.data(), lat.data(), x.data(), y.data(), lon.size(), z);
+
+        // sample each leg at least every half tile and take the neighboring tiles as corridor
+        for (size_t from = 0; from < x.size(); from += 2) {
+            double dx = x[from + 1] - x[from];
+            double dy = y[from + 1] - y[from];
+            int samples = std::max(1, (int) std::ceil(std::max(std::abs(dx), std::abs(dy)) * 2));
+            for (int s = 0; s <= samples; s++) {
+                double t = s / (double) samples;
+                int cx = std::floor(x[from] + t * dx);
+                int cy = std::floor(y[from] + t * dy);
+                for (int ny = cy - 1; ny <= cy + 1; ny++) {
+                    for (int nx = cx - 1; nx <= cx + 1; nx++) {
+                        addTile(page, nx, ny, z);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void TileSeeder::addTile(int page, int x, int y, int zoom) {
+    if (!tileSource->isTileValid(page, x, y, zoom)) {
+        return;
+    }
+
+    TileCoords coords(page, x, y, zoom);
+    if (tileSet.insert(coords).second) {
+        tiles.push_back(coords);
+    }
+}
+
+void TileSeeder::clampZoom(int &minZoom, int &maxZoom) {
+    minZoom = std::max(minZoom, tileSource->getMinZoomLevel());
+    maxZoom = std::min(maxZoom, tileSource->getMaxZoomLevel());
+}
+
+size_t TileSeeder::getTileCount() const {
+    return tiles.size();
+}
+
+void TileSeeder::start(int threads) {
+    if (!workers.empty()) {
+        throw std::logic_error("Seeder already started");
+    }
+
+    if (threads <= 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::max(1, std::min(threads, tileSource->getMaxParallelLoads()));
+
+    {
+        std::lock_guard<std::mutex> lock(progressMutex);
+        progress = Progress();
+        progress.total = tiles.size();
+        progress.running = true;
+        runningWorkers = threads;
+        startTime = std::chrono::steady_clock::now();
+    }
+
+    logger::info("Seeding %d tiles with %d threads", (int) tiles.size(), threads);
+
+    tileSource->resumeLoading();
+    for (int i = 0; i < threads; i++) {
+        workers.push_back(std::thread(&TileSeeder::seedLoop, this));
+    }
+}
+
+void TileSeeder::cancel() {
+    cancelled = true;
+    tileSource->cancelPendingLoads();
+}
+
+void TileSeeder::wait() {
+    for (auto &worker: workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+TileSeeder::Progress TileSeeder::getProgress() {
+    std::lock_guard<std::mutex> lock(progressMutex);
+    Progress res = progress;
+    if (res.running) {
+        res.seconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count() / 1000.0;
+    }
+    return res;
+}
+
+void TileSeeder::seedLoop() {
+    while (!cancelled) {
+        size_t i = nextTile++;
+        if (i >= tiles.size()) {
+            break;
+        }
+        seedTile(tiles[i]);
+    }
+
+    std::lock_guard<std::mutex> lock(progressMutex);
+    if (--runningWorkers == 0) {
+        progress.running = false;
+        progress.seconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count() / 1000.0;
+    }
+}
+
+void TileSeeder::seedTile(const TileCoords &coords) {
+    // gets called unlocked
+    int page = std::get<0>(coords);
+    int x = std::get<1>(coords);
+    int y = std::get<2>(coords);
+    int zoom = std::get<3>(coords);
+
+    bool skipped = false, failed = false;
+    try {
+        std::string name = tileSource->getUniqueTileName(page, x, y, zoom);
+        if (tileStore->hasTile(name)) {
+            skipped = true;
+        } else {
+            auto image = tileSource->loadTileImage(page, x, y, zoom);
+            if (!image->hasEncodedData()) {
+                // rendered tiles
+                image->encodePNG();
+            }
+            tileStore->storeTile(name, *image);
+        }
+    } catch (const std::out_of_range &e) {
+        // cancelled
+        return;
+    } catch (const std::exception &e) {
+        logger::verbose("Couldn't seed tile %d/%d/%d: %s", zoom, x, y, e.what());
+        failed = true;
+    }
+
+    std::lock_guard<std::mutex> lock(progressMutex);
+    if (skipped) {
+        progress.skipped++;
+    } else if (failed) {
+        progress.failed++;
+    } else {
+        progress.stored++;
+    }
+}
+
+TileSeeder::~TileSeeder() {
+    cancel();
+    wait();
+}
+
+} /* namespace img */
@@ -0,0 +1,99 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SRC_LIBIMG_STITCHER_TILESEEDER_H_
+#define SRC_LIBIMG_STITCHER_TILESEEDER_H_
+
+#include <memory>
+#include <vector>
+#include <set>
+#include <tuple>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include "TileSource.h"
+#include "TileStore.h"
+
+namespace img {
+
+/*
+ * Loads all tiles of a region into the tile store of a cache directory so that
+ * they are available offline. Tiles that are already stored are skipped, so an
+ * interrupted run continues where it stopped when it is started again.
+ */
+class TileSeeder {
+public:
+    struct Progress {
+        size_t total = 0;
+        size_t stored = 0;  // loaded from the source and stored
+        size_t skipped = 0; // already in the store
+        size_t failed = 0;
+        double seconds = 0;
+        bool running = false;
+
+        double getTilesPerSecond() const;
+    };
+
+    // Uses the same store as TileCache::setCacheDirectory for this directory
+    TileSeeder(std::shared_ptr<TileSource> source, const std::string &utf8CacheDir);
+
+    // The rectangle is given in tile coordinates of zoom and covered on all levels from minZoom to maxZoom
+    void addArea(int page, Point<double> topLeft, Point<double> bottomRight, int zoom, int minZoom, int maxZoom);
+
+    // Need a source that supports world coordinates, points are lon / lat
+    void addWorldArea(int page, Point<double> corner1, Point<double> corner2, int minZoom, int maxZoom);
+    void addWorldPath(int page, const std::vector<Point<double>> &path, int minZoom, int maxZoom);
+
+    size_t getTileCount() const;
+
+    // threads <= 0 uses one thread per CPU core, never more than the source allows
+    void start(int threads = 0);
+    void cancel();
+    void wait();
+    Progress getProgress();
+
+    ~TileSeeder();
+
+private:
+    using TileCoords = std::tuple<int, int, int, int>; // page, x, y, zoom
+    using TimeStamp = std::chrono::time_point<std::chrono::steady_clock>;
+
+    std::shared_ptr<TileSource> tileSource;
+    std::shared_ptr<TileStore> tileStore;
+
+    std::set<TileCoords> tileSet;
+    std::vector<TileCoords> tiles;
+
+    std::vector<std::thread> workers;
+    std::atomic<size_t> nextTile { 0 };
+    std::atomic_bool cancelled { false };
+
+    std::mutex progressMutex;
+    Progress progress;
+    int runningWorkers = 0;
+    TimeStamp startTime;
+
+    void addTile(int page, int x, int y, int zoom);
+    void clampZoom(int &minZoom, int &maxZoom);
+    void seedLoop();
+    void seedTile(const TileCoords &coords);
+};
+
+} /* namespace img */
+
+#endif /* SRC_LIBIMG_STITCHER_TILESEEDER_H_ */
@@ -20,6 +20,9 @@
 
 #include "src/libimg/Image.h"
 #include <string>
+#include <vector>
+#include <functional>
+#include <exception>
 
 namespace img {
 
@@ -31,6 +34,8 @@ struct Point {
 
 class TileSource {
 public:
+    using TileDataCallback = std::function<void(std::vector<uint8_t> data, std::exception_ptr error)>;
+
     // Basic information
     virtual int getMinZoomLevel() = 0;
     virtual int getMaxZoomLevel() = 0;
@@ -44,15 +49,46 @@ public:
     virtual void cancelPendingLoads() = 0;
     virtual void resumeLoading() = 0;
 
+    // How many loadTileImage calls may run at the same time, 1 if the source is not thread-safe
+    virtual int getMaxParallelLoads() { return 1; }
+
+    // Whether it is worth fetching tiles into the disk cache before they are visible,
+    // i.e. loading is slow and the loaded tiles can be stored
+    virtual bool supportsPrefetch() { return false; }
+
+    // Whether it is worth storing the tiles for offline use, i.e. they are downloaded or expensive
+    // to render. Tiles without encoded data are stored as PNG.
+    virtual bool supportsSeeding() { return false; }
+
     // Query and load tile information
     virtual int getPageCount() = 0;
     virtual bool isTileValid(int page, int x, int y, int zoom) = 0;
     virtual std::string getUniqueTileName(int page, int x, int y, int zoom) = 0;
     virtual std::unique_ptr<img::Image> loadTileImage(int page, int x, int y, int zoom) = 0;
 
+    // Sources that download their tiles can do so without blocking a loader thread: start the
+    // download, return true and call onDone later from any thread. decodeTileData then runs on
+    // a loader thread. If this returns false, loadTileImage is used instead.
+    virtual bool startTileDownload(int page, int x, int y, int zoom, TileDataCallback onDone) { return false; }
+    virtual std::unique_ptr<img::Image> decodeTileData(int page, int x, int y, int zoom, std::vector<uint8_t> &data) {
+        auto image = std::make_unique<img::Image>();
+        image->loadEncodedData(data, true);
+        return image;
+    }
+
     // World position support
     virtual Point<double> worldToXY(double lon, double lat, int zoom) = 0;
     virtual Point<double> xyToWorld(double x, double y, int zoom) = 0;
+
+    // Projects count positions at once, sources with a closed-form projection should override this
+    virtual void worldToXYBatch(const double *lon, const double *lat, double *x, double *y, size_t count, int zoom) {
+        for (size_t i = 0; i < count; i++) {
+            auto xy = worldToXY(lon[i], lat[i], zoom);
+            x[i] = xy.x;
+            y[i] = xy.y;
+        }
+    }
+
     virtual void attachCalibration1(double x, double y, double lat, double lon, int zoom) {}
     virtual void attachCalibration2(double x, double y, double lat, double lon, int zoom) {}
 
@@ -0,0 +1,44 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SRC_LIBIMG_STITCHER_TILESTORE_H_
+#define SRC_LIBIMG_STITCHER_TILESTORE_H_
+
+#include <memory>
+#include <string>
+#include "src/libimg/Image.h"
+
+namespace img {
+
+// Persistent storage for tiles, addressed by TileSource::getUniqueTileName
+class TileStore {
+public:
+    // Returns nullptr if the tile is not stored
+    virtual std::shared_ptr<Image> loadTile(const std::string &name) = 0;
+
+    // No effect if the image was not loaded via loadEncodedData with keepData
+    virtual void storeTile(const std::string &name, Image &image) = 0;
+
+    // Cheaper than loadTile because nothing is decoded
+    virtual bool hasTile(const std::string &name) = 0;
+
+    virtual ~TileStore() = default;
+};
+
+} /* namespace img */
+
+#endif /* SRC_LIBIMG_STITCHER_TILESTORE_H_ */
@@ -16,9 +16,12 @@
  *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include <chrono>
-#include <thread>
+#include <future>
+#include <algorithm>
+#include <cmath>
 
 #include "XData.h"
+#include "src/libxdata/world/loaders/AirportLoader.h"
 #include "src/libxdata/world/loaders/FixLoader.h"
 #include "src/libxdata/world/loaders/NavaidLoader.h"
 #include "src/libxdata/world/loaders/AirwayLoader.h"
@@ -37,6 +40,10 @@ XData::XData(const std::string& dataRootPath):
     navDataPath = determineNavDataPath();
 }
 
+XData::~XData() {
+    stopProcedureWarmUp();
+}
+
 std::string XData::determineNavDataPath() {
     if (platform::fileExists(xplaneRoot + "Custom Data/earth_nav.dat")) {
         return xplaneRoot + "Custom Data/";
@@ -73,87 +80,242 @@ void XData::setUserFixesFilename(std::string filename) {
     userFixesFilename = filename;
 }
 
+void XData::setSnapshotPath(const std::string& utf8Path) {
+    snapshotPath = utf8Path;
+}
+
 std::shared_ptr<World> XData::getWorld() {
     return world;
 }
 
 void XData::load() {
     auto startAt = std::chrono::steady_clock::now();
-    logger::verbose("Loading airports...");
-    loadAirports();
-    logger::verbose("Loading fixes...");
-    loadFixes();
-    logger::verbose("Loading navaids...");
-    loadNavaids();
-    logger::verbose("Loading airways...");
-    loadAirways();
-    logger::verbose("Loading CIFP...");
-    loadProcedures();
+
+    std::unique_ptr<NavDataSnapshot> snapshot;
+    if (!snapshotPath.empty()) {
+        snapshot = std::make_unique<NavDataSnapshot>(snapshotPath);
+        addSnapshotSources(*snapshot);
+    }
+
+    if (snapshot && snapshot->open()) {
+        logger::verbose("Loading nav data snapshot...");
+        loadFromSnapshot(*snapshot);
+    } else {
+        if (snapshot) {
+            try {
+                snapshot->create();
+            } catch (const std::exception &e) {
+                logger::warn("Not creating nav data snapshot: %s", e.what());
+                snapshot.reset();
+            }
+        }
+
+        loadFromText(snapshot.get());
+
+        if (snapshot) {
+            try {
+                snapshot->finish();
+                logger::info("Created nav data snapshot %s", snapshotPath.c_str());
+            } catch (const std::exception &e) {
+                logger::warn("Couldn't create nav data snapshot: %s", e.what());
+            }
+        }
+    }
+
     logger::verbose("Attempting to load user fixes...");
     loadUserFixes();
     auto duration = std::chrono::steady_clock::now() - startAt;
     auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
 
     loadMetar();
+    setProcedureLoaders();
 
     logger::verbose("Build node network...");
     world->registerNavNodes();
     logger::info("Loaded nav data in %.2f seconds", millis / 1000.0f);
 }
 
-void XData::cancelLoading() {
-    world->cancelLoading();
+void XData::addSnapshotSources(NavDataSnapshot& snapshot) {
+    // the order must match the order of the files in the snapshot
+    for (auto &aptDatPath: customSceneries) {
+        snapshot.addSourceFile(aptDatPath);
+    }
+    snapshot.addSourceFile(xplaneRoot + "Resources/default scenery/default apt dat/Earth nav data/apt.dat");
+    snapshot.addSourceFile(navDataPath + "earth_fix.dat");
+    snapshot.addSourceFile(navDataPath + "earth_nav.dat");
+    snapshot.addSourceFile(navDataPath + "earth_awy.dat");
 }
 
-void XData::loadAirports() {
-    const AirportLoader loader(world);
+void XData::loadFromSnapshot(NavDataSnapshot& snapshot) {
+    logger::verbose("Loading airports...");
+    loadAirports(snapshot.readAirports());
+    logger::verbose("Loading fixes...");
+    FixLoader(world).apply(snapshot.readFixes());
+    logger::verbose("Loading navaids...");
+    NavaidLoader(world).apply(snapshot.readNavaids());
+    logger::verbose("Loading airways...");
+    AirwayLoader(world).apply(snapshot.readAirways());
+}
 
-    loadCustomScenery(loader);
+void XData::loadFromText(NavDataSnapshot *snapshot) {
+    // Parsing the text files takes most of the time and doesn't touch the world,
+    // so the files are parsed concurrently. The world is still built in the
+    // original order because later files refer to objects of earlier ones.
+    auto airports = std::async(std::launch::async, &XData::parseAirports, this);
+    auto fixes = std::async(std::launch::async, [this] () {
+        return FixLoader(world).parse(navDataPath + "earth_fix.dat");
+    });
+    auto navaids = std::async(std::launch::async, [this] () {
+        return NavaidLoader(world).parse(navDataPath + "earth_nav.dat");
+    });
+    auto airways = std::async(std::launch::async, [this] () {
+        return AirwayLoader(world).parse(navDataPath + "earth_awy.dat");
+    });
 
-    logger::verbose("Loading default apt.dat");
-    loader.load(xplaneRoot + "Resources/default scenery/default apt dat/Earth nav data/apt.dat");
+    // the snapshot stores the records in the order they are applied
+    logger::verbose("Loading airports...");
+    auto airportFiles = airports.get();
+    loadAirports(airportFiles);
+    if (snapshot) {
+        snapshot->writeAirports(airportFiles);
+    }
+
+    logger::verbose("Loading fixes...");
+    auto fixData = fixes.get();
+    FixLoader(world).apply(fixData);
+    if (snapshot) {
+        snapshot->writeFixes(fixData);
+    }
+
+    logger::verbose("Loading navaids...");
+    auto navaidData = navaids.get();
+    NavaidLoader(world).apply(navaidData);
+    if (snapshot) {
+        snapshot->writeNavaids(navaidData);
+    }
+
+    logger::verbose("Loading airways...");
+    auto airwayData = airways.get();
+    AirwayLoader(world).apply(airwayData);
+    if (snapshot) {
+        snapshot->writeAirways(airwayData);
+    }
 }
 
-void XData::loadCustomScenery(const AirportLoader& loader) {
+void XData::cancelLoading() {
+    // also stops the procedure warm-up
+    world->cancelLoading();
+}
+
+std::vector<std::vector<AirportData>> XData::parseAirports() {
+    // custom sceneries first so that they take precedence
+    const AirportLoader loader(world);
+    std::vector<std::vector<AirportData>> res;
+
     for (auto &aptDatPath: customSceneries) {
         try {
             logger::info("Loading custom scenery airport for %s", aptDatPath.c_str());
-            loader.load(aptDatPath);
+            res.push_back(loader.parse(aptDatPath));
         } catch (const std::exception &e) {
             logger::warn("Unable to parse custom scenery: %s", e.what());
         }
     }
-}
 
-void XData::loadFixes() {
-    FixLoader loader(world);
-    loader.load(navDataPath + "earth_fix.dat");
-}
+    logger::verbose("Loading default apt.dat");
+    res.push_back(loader.parse(xplaneRoot + "Resources/default scenery/default apt dat/Earth nav data/apt.dat"));
 
-void XData::loadNavaids() {
-    NavaidLoader loader(world);
-    loader.load(navDataPath + "earth_nav.dat");
+    return res;
 }
 
-void XData::loadAirways() {
-    AirwayLoader loader(world);
-    loader.load(navDataPath + "earth_awy.dat");
+void XData::loadAirports(const std::vector<std::vector<AirportData>> &airportFiles) {
+    const AirportLoader loader(world);
+    for (auto &airports: airportFiles) {
+        loader.apply(airports);
+    }
 }
 
-void XData::loadProcedures() {
-    CIFPLoader loader(world);
-    world->forEachAirport([this, &loader] (std::shared_ptr<Airport> ap) {
+void XData::setProcedureLoaders() {
+    // The CIFP file of an airport is only parsed when its procedures are needed.
+    // Applying them connects global fixes to the airport, so the world is told
+    // to rebuild its nav graph afterwards.
+    std::weak_ptr<World> weakWorld = world;
+    std::string cifpDir = navDataPath + "CIFP/";
+
+    auto loader = std::make_shared<const Airport::ProcedureLoader>([weakWorld, cifpDir] (std::shared_ptr<Airport> airport) {
+        auto world = weakWorld.lock();
+        if (!world) {
+            return;
+        }
+
+        std::string path = cifpDir + airport->getID() + ".dat";
+        if (!platform::fileExists(path)) {
+            // many airports do not have CIFP data, so ignore silently
+            return;
+        }
+
         try {
-            loader.load(ap, navDataPath + "CIFP/" + ap->getID() + ".dat");
+            CIFPLoader cifpLoader(world);
+            auto procedures = cifpLoader.parse(path);
+            world->changeConnections([&cifpLoader, &airport, &procedures] () {
+                cifpLoader.apply(airport, procedures);
+            });
+            logger::verbose("Loaded %d procedures for %s", (int) procedures.size(), airport->getID().c_str());
         } catch (const std::exception &e) {
-            // many airports do not have CIFP data, so ignore silently
+            logger::warn("Couldn't load procedures for %s: %s", airport->getID().c_str(), e.what());
         }
-        if (world->shouldCancelLoading()) {
-            throw std::runtime_error("Cancelled");
+    });
+
+    world->forEachAirport([&loader] (std::shared_ptr<Airport> ap) {
+        ap->setProcedureLoader(loader);
+    });
+}
+
+void XData::warmUpProcedures(const Location& center) {
+    stopProcedureWarmUp();
+
+    if (!center.isValid() || world->shouldCancelLoading()) {
+        return;
+    }
+
+    double deltaLat = WARM_UP_RADIUS_KM / 111.0;
+    double deltaLon = deltaLat / std::max(0.1, std::cos(center.latitude * M_PI / 180.0));
+    Location upLeft(center.latitude + deltaLat, center.longitude - deltaLon);
+    Location lowRight(center.latitude - deltaLat, center.longitude + deltaLon);
+
+    std::vector<std::shared_ptr<Airport>> airports;
+    world->visitNodes(upLeft, lowRight, [this, &airports] (const NavNode &node) {
+        auto airport = world->findAirportByID(node.getID());
+        if (airport) {
+            airports.push_back(airport);
         }
+    }, World::LAYER_AIRPORTS);
+
+    std::sort(airports.begin(), airports.end(), [&center] (const std::shared_ptr<Airport> &a, const std::shared_ptr<Airport> &b) {
+        return center.distanceTo(a->getLocation()) < center.distanceTo(b->getLocation());
+    });
+    if (airports.size() > WARM_UP_MAX_AIRPORTS) {
+        airports.resize(WARM_UP_MAX_AIRPORTS);
+    }
+
+    stopWarmUp = false;
+    warmUpThread = std::thread([this, airports] () {
+        for (auto &airport: airports) {
+            if (stopWarmUp || world->shouldCancelLoading()) {
+                return;
+            }
+            airport->loadProcedures();
+        }
+        logger::verbose("Loaded procedures of %d nearby airports", (int) airports.size());
     });
 }
 
+void XData::stopProcedureWarmUp() {
+    stopWarmUp = true;
+    if (warmUpThread.joinable()) {
+        warmUpThread.join();
+    }
+}
+
 void XData::loadMetar() {
     using namespace std::placeholders;
 
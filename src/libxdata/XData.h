@@ -21,8 +21,11 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <thread>
+#include <atomic>
 #include "src/libxdata/world/World.h"
-#include "src/libxdata/world/loaders/AirportLoader.h"
+#include "src/libxdata/parsers/objects/AirportData.h"
+#include "src/libxdata/world/loaders/NavDataSnapshot.h"
 
 namespace xdata {
 
@@ -36,22 +39,37 @@ public:
     void loadUserFixes(std::string filename);
     std::shared_ptr<World> getWorld();
     void setUserFixesFilename(std::string filename);
+    void setSnapshotPath(const std::string &utf8Path);
+
+    // Optional: loads the procedures of the airports around a location in the background,
+    // otherwise they are loaded when first accessed
+    void warmUpProcedures(const Location &center);
+
+    ~XData();
 private:
     std::string xplaneRoot;
     std::string navDataPath;
     std::shared_ptr<World> world;
     std::vector<std::string> customSceneries;
     std::string userFixesFilename;
+    std::string snapshotPath;
+    std::thread warmUpThread;
+    std::atomic_bool stopWarmUp { false };
 
     std::string determineNavDataPath();
 
-    void loadAirports();
-    void loadFixes();
-    void loadNavaids();
-    void loadAirways();
-    void loadProcedures();
+    static constexpr const double WARM_UP_RADIUS_KM = 100;
+    static constexpr const size_t WARM_UP_MAX_AIRPORTS = 50;
+
+    void addSnapshotSources(NavDataSnapshot &snapshot);
+    void loadFromSnapshot(NavDataSnapshot &snapshot);
+    void loadFromText(NavDataSnapshot *snapshot);
+
+    std::vector<std::vector<AirportData>> parseAirports();
+    void loadAirports(const std::vector<std::vector<AirportData>> &airportFiles);
+    void setProcedureLoaders();
+    void stopProcedureWarmUp();
     void loadMetar();
-    void loadCustomScenery(const AirportLoader& loader);
     void loadUserFixes();
 
 };
@@ -16,107 +16,147 @@
  *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include "BaseParser.h"
-#include <iostream>
+#include <charconv>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
 #include <stdexcept>
 #include <limits>
 #include "src/Logger.h"
 
 namespace xdata {
 
-BaseParser::BaseParser(const std::string& file) {
-    stream.open(fs::u8path(file));
+namespace {
 
-    if (!stream) {
-        throw std::runtime_error("Couldn't open file: " + file);
-    }
+// the C locale's isspace without the function call
+inline bool isSpace(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+}
+
+BaseParser::BaseParser(const std::string& file):
+    file(std::make_unique<platform::MappedFile>(file))
+{
+    filePos = this->file->getData();
+    fileEnd = filePos + this->file->getSize();
 }
 
 std::string BaseParser::parseHeader() {
-    std::string line;
+    if (!nextLine()) {
+        throw std::runtime_error("Unknown file format: ");
+    }
 
-    getLine(line);
+    std::string_view line(linePos, lineEnd - linePos);
     if (line != "A" && line != "I") {
-        throw std::runtime_error("Unknown file format: " + line);
+        throw std::runtime_error("Unknown file format: " + std::string(line));
     }
 
-    getLine(line);
-
-    std::istringstream lineStr(line);
-    char origin;
-    std::string header;
+    if (!nextLine()) {
+        return "";
+    }
 
-    lineStr >> origin >> version;
-    getline(lineStr, header);
-    return header;
+    version = parseInt();
+    return std::string(linePos, lineEnd - linePos);
 }
 
 void BaseParser::eachLine(LineFunctor f) {
-    std::string line;
-    while (getline(stream, line)) {
-        lineStream.str(line);
-        lineStream.seekg(0);
-        lineStream.clear();
+    while (nextLine()) {
         f();
     }
 }
 
+bool BaseParser::nextLine() {
+    if (filePos >= fileEnd) {
+        return false;
+    }
+
+    const char *eol = (const char *) std::memchr(filePos, '\n', fileEnd - filePos);
+    if (!eol) {
+        eol = fileEnd;
+    }
+
+    linePos = filePos;
+    lineEnd = eol;
+    filePos = (eol < fileEnd) ? eol + 1 : fileEnd;
+
+    // lines are handled the same for CRLF and LF files
+    if (lineEnd > linePos && lineEnd[-1] == '\r') {
+        lineEnd--;
+    }
+
+    return true;
+}
+
 bool BaseParser::isEOL() {
-    return lineStream.peek() <= '\0';
+    return linePos >= lineEnd || *linePos == '\0';
 }
 
 std::string BaseParser::restOfLine() {
     skipWhiteSpace();
 
-    std::string rest;
-    std::getline(lineStream, rest);
+    std::string rest(linePos, lineEnd - linePos);
+    linePos = lineEnd;
     return rest;
 }
 
 int BaseParser::parseInt() {
     skipWhiteSpace();
 
-    int res;
-    if (lineStream >> res) {
-        return res;
-    } else {
+    const char *start = linePos;
+    if (start < lineEnd && *start == '+' && start + 1 < lineEnd && start[1] != '-') {
+        start++;
+    }
+
+    int res = 0;
+    auto conv = std::from_chars(start, lineEnd, res);
+    if (conv.ec != std::errc()) {
+        linePos = lineEnd;
         return 0;
     }
+
+    linePos = conv.ptr;
+    return res;
 }
 
 std::string BaseParser::parseWord() {
+    return std::string(nextToken());
+}
+
+std::string_view BaseParser::nextToken() {
     skipWhiteSpace();
 
-    std::string word;
-    lineStream >> word;
-    return word;
+    const char *start = linePos;
+    while (linePos < lineEnd && !isSpace(*linePos)) {
+        linePos++;
+    }
+    return std::string_view(start, linePos - start);
 }
 
 std::string BaseParser::nextDelimitedWord(char delim) {
-    std::stringstream word;
-
-    char c = '\0';
+    std::string word;
 
-    while (lineStream >> c) {
+    while (linePos < lineEnd) {
+        char c = *linePos++;
         if (c == delim) {
             break;
         }
 
-        if (!std::isspace(c)) {
-            word << c;
+        if (!isSpace(c)) {
+            word += c;
         }
     }
 
-    return word.str();
+    return word;
 }
 
 std::string BaseParser::nextCSVValue() {
-    std::stringstream value;
-    lineStream >> std::noskipws; // Keep whitespace inside CSV values
+    std::string value; // Keep whitespace inside CSV values
 
     bool inQuotes = false; // Ensure commas inside quoted fields are not separators
-    char c = '\0';
 
-    while (lineStream >> c) {
+    while (linePos < lineEnd) {
+        char c = *linePos++;
         if (c == '"') {
             inQuotes = !inQuotes;
             continue;
@@ -124,68 +164,55 @@ std::string BaseParser::nextCSVValue() {
         if (c == ',' && !inQuotes) {
             break;
         }
-        value << c;
+        value += c;
     }
 
-    lineStream >> std::skipws;
-    return value.str();
+    return value;
 }
 
 double BaseParser::parseDouble() {
-    skipWhiteSpace();
+    std::string_view token = nextToken();
+    if (token.size() > 1 && token[0] == '+' && token[1] != '+' && token[1] != '-') {
+        token.remove_prefix(1);
+    }
 
-    std::string doubleStr;
-    lineStream >> doubleStr;
+    double res;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    auto conv = std::from_chars(token.data(), token.data() + token.size(), res);
+    if (conv.ec != std::errc()) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+#else
+    // floating point from_chars is missing in older standard libraries
+    char buf[64];
+    if (token.empty() || token.size() >= sizeof(buf)) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    std::memcpy(buf, token.data(), token.size());
+    buf[token.size()] = '\0';
 
-    try {
-        return std::stod(doubleStr);
-    } catch (...) {
+    char *endPtr;
+    errno = 0;
+    res = std::strtod(buf, &endPtr);
+    if (endPtr == buf || errno == ERANGE) {
         return std::numeric_limits<double>::quiet_NaN();
     }
+#endif
+
+    return res;
 }
 
 void BaseParser::skip(char c) {
-    char is;
-    lineStream >> is;
-    if (is != c) {
+    skipWhiteSpace();
+
+    if (linePos >= lineEnd || *linePos++ != c) {
         throw std::runtime_error("Unexpected char in data");
     }
 }
 
 void BaseParser::skipWhiteSpace() {
-    char c;
-    do {
-        if (!(lineStream >> c)) {
-            return;
-        }
-    } while (std::isspace(c));
-    lineStream.putback(c);
-}
-
-std::istream& BaseParser::getLine(std::string& str) {
-    stream.clear();
-
-    std::istream::sentry se(stream, true);
-    std::streambuf *sbuf = stream.rdbuf();
-
-    while (true) {
-        int c = sbuf->sbumpc();
-        switch (c) {
-        case '\n':
-            return stream;
-        case '\r':
-            if (sbuf->sgetc() == '\n') {
-                sbuf->sbumpc();
-            }
-            return stream;
-        case std::streambuf::traits_type::eof():
-            if (str.empty()) {
-                stream.setstate(std::ios::eofbit);
-            }
-            return stream;
-        default:
-            str += static_cast<char>(c);
-        }
+    while (linePos < lineEnd && isSpace(*linePos)) {
+        linePos++;
     }
 }
 
@@ -19,13 +19,21 @@
 #define SRC_LIBXDATA_LOADERS_PARSERS_BASEPARSER_H_
 
 #include <string>
+#include <string_view>
 #include <functional>
-#include <sstream>
-#include <iosfwd>
-#include "src/platform/Platform.h"
+#include <memory>
+#include "src/platform/MappedFile.h"
 
 namespace xdata {
 
+/*
+ * Tokenizes a memory mapped text file. The lines are only views into
+ * the mapping, so only the returned values are copied.
+ *
+ * A failed parseInt ends the current line, i.e. all following calls
+ * return empty values until the next line like with the stream based
+ * parser this replaced.
+ */
 class BaseParser {
 public:
     using LineFunctor = std::function<void()>;
@@ -46,10 +54,13 @@ public:
     void skipWhiteSpace();
     int getVersion();
 private:
-    fs::ifstream stream;
-    std::istringstream lineStream;
-    std::istream &getLine(std::string &str);
-    int version;
+    std::unique_ptr<platform::MappedFile> file;
+    const char *filePos = nullptr, *fileEnd = nullptr;
+    const char *linePos = nullptr, *lineEnd = nullptr;
+    int version = 0;
+
+    bool nextLine();
+    std::string_view nextToken();
 };
 
 } /* namespace xdata */
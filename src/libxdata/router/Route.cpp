@@ -22,11 +22,12 @@
 
 namespace xdata {
 
-Route::Route(std::shared_ptr<NavNode> start, std::shared_ptr<NavNode> dest):
+Route::Route(std::shared_ptr<const NavGraph> graph, std::shared_ptr<NavNode> start, std::shared_ptr<NavNode> dest):
+    router(graph),
     startNode(start),
     destNode(dest)
 {
-    router.setEdgeFilter([this] (const RouteFinder::EdgePtr via, const RouteFinder::NodePtr to) {
+    router.setEdgeFilter([this] (const RouteFinder::EdgePtr &via, const RouteFinder::NodePtr &to) {
         return checkEdge(via, to);
     });
 }
@@ -44,17 +45,18 @@ std::shared_ptr<NavNode> Route::getDestination() const {
 }
 
 void Route::find() {
+    router.setLevelMask(NavGraph::getLevelMask(airwayLevel));
     waypoints = router.findRoute(startNode, destNode);
 }
 
-bool Route::checkEdge(const RouteFinder::EdgePtr via, const RouteFinder::NodePtr to) const {
+bool Route::checkEdge(const RouteFinder::EdgePtr &via, const RouteFinder::NodePtr &to) const {
     if (via->isProcedure()) {
         // We only allow SIDs, STARs etc. if they are start or end of the route.
         // This prevents routes that use SIDs and STARs of other airports as waypoints
         return startNode->isConnectedTo(to) || to == destNode;
     } else {
-        // Normal airways are allowed if their level matches the desired level
-        return via->supportsLevel(airwayLevel);
+        // Normal airways were already checked against the level mask by the router
+        return true;
     }
 
 }
@@ -30,7 +30,7 @@ class Route {
 public:
     using RouteIterator = std::function<void (const std::shared_ptr<NavEdge>, const std::shared_ptr<NavNode>)>;
 
-    Route(std::shared_ptr<NavNode> start, std::shared_ptr<NavNode> dest);
+    Route(std::shared_ptr<const NavGraph> graph, std::shared_ptr<NavNode> start, std::shared_ptr<NavNode> dest);
 
     void setAirwayLevel(AirwayLevel level);
 
@@ -50,7 +50,7 @@ private:
     AirwayLevel airwayLevel = AirwayLevel::LOWER;
     std::vector<RouteFinder::RouteDirection> waypoints;
 
-    bool checkEdge(const RouteFinder::EdgePtr via, const RouteFinder::NodePtr to) const;
+    bool checkEdge(const RouteFinder::EdgePtr &via, const RouteFinder::NodePtr &to) const;
 };
 
 } /* namespace xdata */
@@ -23,6 +23,15 @@
 
 namespace xdata {
 
+RouteFinder::RouteFinder(std::shared_ptr<const NavGraph> graph):
+    graph(graph)
+{
+}
+
+void RouteFinder::setLevelMask(uint8_t mask) {
+    levelMask = mask;
+}
+
 void RouteFinder::setAirwayChangePenalty(float percent) {
     airwayChangePenalty = percent;
 }
@@ -35,55 +44,67 @@ std::vector<RouteFinder::RouteDirection> RouteFinder::findRoute(NodePtr from, No
     logger::verbose("Searching route from %s to %s", from->getID().c_str(), goal->getID().c_str());
     directDistance = from->getLocation().distanceTo(goal->getLocation());
 
+    if (!graph) {
+        throw std::runtime_error("Nav graph not built");
+    }
+
+    int fromGraphIdx = graph->getIndex(from.get());
+    int goalGraphIdx = graph->getIndex(goal.get());
+    if (fromGraphIdx < 0 || goalGraphIdx < 0) {
+        logger::verbose("Start or destination not in nav graph");
+        throw std::runtime_error("No route found");
+    }
+    const Location &goalLocation = graph->getLocation(goalGraphIdx);
+
     // Init
-    closedSet.clear();
-    openSet.clear();
-    openSet.insert(from);
-    cameFrom.clear();
-    gScore.clear();
+    nodes.clear();
+    localIndex.assign(graph->getNodeCount(), -1);
+    openHeap.clear();
 
     // The cost from start to start is zero
-    gScore[from] = 0;
-    fScore[from] = minCostHeuristic(from, goal);
-
-    while (!openSet.empty()) {
-        NodePtr current = getLowestOpen();
-        if (current == goal) {
-            logger::verbose("Route found");
-            return reconstructPath(goal);
+    int fromIdx = getIndex(fromGraphIdx);
+    nodes[fromIdx].gScore = 0;
+    nodes[fromIdx].fScore = minCostHeuristic(fromGraphIdx, goalLocation);
+    pushOrUpdateOpen(fromIdx);
+
+    while (!openHeap.empty()) {
+        int currentIdx = popLowestOpen();
+        int currentGraphIdx = nodes[currentIdx].graphIdx;
+        if (currentGraphIdx == goalGraphIdx) {
+            logger::verbose("Route found, visited %d nodes", (int) nodes.size());
+            return reconstructPath(currentIdx);
         }
 
-        openSet.erase(current);
-        closedSet.insert(current);
+        nodes[currentIdx].closed = true;
 
-        auto &neighbors = current->getConnections();
-        for (auto neighborConn: neighbors) {
-            auto &edge = std::get<0>(neighborConn);
-            auto &neighbor = std::get<1>(neighborConn);
-            if (!edge || !neighbor) {
+        uint32_t connEnd = graph->getEndConnection(currentGraphIdx);
+        for (uint32_t conn = graph->getFirstConnection(currentGraphIdx); conn < connEnd; conn++) {
+            uint8_t levels = graph->getLevels(conn);
+            if (!(levels & NavGraph::PROCEDURE) && !(levels & levelMask)) {
                 continue;
             }
 
-            if (!edgeFilter(edge, neighbor)) {
+            int neighborGraphIdx = graph->getNeighbor(conn);
+            if (edgeFilter && !edgeFilter(graph->getEdge(graph->getEdgeIndex(conn)), graph->getNode(neighborGraphIdx))) {
                 continue;
             }
 
-            if (closedSet.find(neighbor) != closedSet.end()) {
+            int neighborIdx = getIndex(neighborGraphIdx);
+            if (nodes[neighborIdx].closed) {
                 continue;
             }
 
-            if (openSet.find(neighbor) == openSet.end()) {
-                openSet.insert(neighbor);
-            }
-
-            double tentativeGScore = getGScore(current) + cost(current, RouteDirection(edge, neighbor));
-            if (tentativeGScore > getGScore(neighbor)) {
+            double tentativeGScore = nodes[currentIdx].gScore + cost(currentIdx, conn);
+            if (tentativeGScore > nodes[neighborIdx].gScore) {
                 continue;
             }
 
-            cameFrom[neighbor] = RouteDirection(edge, current);
-            gScore[neighbor] = tentativeGScore;
-            fScore[neighbor] = getGScore(neighbor) + minCostHeuristic(neighbor, goal);
+            NodeState &state = nodes[neighborIdx];
+            state.cameVia = graph->getEdgeIndex(conn);
+            state.cameFrom = currentIdx;
+            state.gScore = tentativeGScore;
+            state.fScore = tentativeGScore + minCostHeuristic(neighborGraphIdx, goalLocation);
+            pushOrUpdateOpen(neighborIdx);
         }
     }
 
@@ -91,65 +112,118 @@ std::vector<RouteFinder::RouteDirection> RouteFinder::findRoute(NodePtr from, No
     throw std::runtime_error("No route found");
 }
 
-std::vector<RouteFinder::RouteDirection> RouteFinder::reconstructPath(NodePtr lastFix) {
+std::vector<RouteFinder::RouteDirection> RouteFinder::reconstructPath(int lastIdx) {
     logger::info("Backtracking route...");
     std::vector<RouteDirection> res;
 
-    RouteDirection cur = cameFrom[lastFix];
-    res.push_back(RouteDirection(cur.via, lastFix));
+    int idx = lastIdx;
+    do {
+        EdgePtr via;
+        if (nodes[idx].cameVia >= 0) {
+            via = graph->getEdge(nodes[idx].cameVia);
+        }
+        res.push_back(RouteDirection(via, graph->getNode(nodes[idx].graphIdx)));
+        idx = nodes[idx].cameFrom;
+    } while (idx >= 0 && nodes[idx].cameFrom >= 0);
 
-    decltype(cameFrom.find(nullptr)) it;
+    std::reverse(std::begin(res), std::end(res));
 
-    while ((it = cameFrom.find(cur.to)) != cameFrom.end()) {
-        cur = cameFrom[it->first];
-        res.push_back(RouteDirection(cur.via, it->first));
+    return res;
+}
+
+int RouteFinder::getIndex(int graphIdx) {
+    int idx = localIndex[graphIdx];
+    if (idx >= 0) {
+        return idx;
     }
 
-    std::reverse(std::begin(res), std::end(res));
+    idx = nodes.size();
+    NodeState state;
+    state.graphIdx = graphIdx;
+    nodes.push_back(state);
+    localIndex[graphIdx] = idx;
+    return idx;
+}
+
+void RouteFinder::pushOrUpdateOpen(int idx) {
+    // scores only decrease while a node is open, so sifting up is enough
+    if (nodes[idx].heapPos < 0) {
+        openHeap.push_back(idx);
+        nodes[idx].heapPos = openHeap.size() - 1;
+    }
+    siftUp(nodes[idx].heapPos);
+}
+
+int RouteFinder::popLowestOpen() {
+    int res = openHeap.front();
+    nodes[res].heapPos = -1;
 
+    int last = openHeap.back();
+    openHeap.pop_back();
+    if (!openHeap.empty()) {
+        setHeapEntry(0, last);
+        siftDown(0);
+    }
     return res;
 }
 
-RouteFinder::NodePtr RouteFinder::getLowestOpen() {
-    NodePtr res = nullptr;
-    double best = std::numeric_limits<double>::infinity();
+void RouteFinder::siftUp(size_t pos) {
+    int idx = openHeap[pos];
+    double score = nodes[idx].fScore;
 
-    for (NodePtr f: openSet) {
-        auto fScoreIt = fScore.find(f);
-        if (fScoreIt != fScore.end()) {
-            if (fScoreIt->second < best) {
-                res = fScoreIt->first;
-                best = fScoreIt->second;
-            }
+    while (pos > 0) {
+        size_t parent = (pos - 1) / 2;
+        if (nodes[openHeap[parent]].fScore <= score) {
+            break;
         }
+        setHeapEntry(pos, openHeap[parent]);
+        pos = parent;
     }
-    return res;
+    setHeapEntry(pos, idx);
+}
+
+void RouteFinder::siftDown(size_t pos) {
+    int idx = openHeap[pos];
+    double score = nodes[idx].fScore;
+    size_t count = openHeap.size();
+
+    while (true) {
+        size_t child = 2 * pos + 1;
+        if (child >= count) {
+            break;
+        }
+        if (child + 1 < count && nodes[openHeap[child + 1]].fScore < nodes[openHeap[child]].fScore) {
+            child++;
+        }
+        if (score <= nodes[openHeap[child]].fScore) {
+            break;
+        }
+        setHeapEntry(pos, openHeap[child]);
+        pos = child;
+    }
+    setHeapEntry(pos, idx);
 }
 
-double RouteFinder::minCostHeuristic(NodePtr a, NodePtr b) {
+void RouteFinder::setHeapEntry(size_t pos, int idx) {
+    openHeap[pos] = idx;
+    nodes[idx].heapPos = pos;
+}
+
+double RouteFinder::minCostHeuristic(int idx, const Location &goal) {
     // the minimum cost is a direct line
-    return a->getLocation().distanceTo(b->getLocation());
+    return graph->getLocation(idx).distanceTo(goal);
 }
 
-double RouteFinder::cost(NodePtr a, const RouteDirection& dir) {
+double RouteFinder::cost(int from, uint32_t conn) {
     // the actual cost can have penalties later
     double penalty = 0;
-    auto it = cameFrom.find(a);
-    if (it != cameFrom.end()) {
-        if (it->second.via != dir.via) {
+    if (nodes[from].cameFrom >= 0) {
+        if (nodes[from].cameVia != graph->getEdgeIndex(conn)) {
             penalty += airwayChangePenalty * directDistance;
         }
     }
 
-    return minCostHeuristic(a, dir.to) + penalty;
-}
-
-double RouteFinder::getGScore(NodePtr f) {
-    auto it = gScore.find(f);
-    if (it == gScore.end()) {
-        return std::numeric_limits<double>::infinity();
-    }
-    return it->second;
+    return graph->getLength(conn) + penalty;
 }
 
 } /* namespace xdata */
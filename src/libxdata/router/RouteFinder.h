@@ -20,10 +20,10 @@
 
 #include <vector>
 #include <memory>
-#include <set>
-#include <map>
+#include <limits>
 #include <functional>
 #include "src/libxdata/world/graph/NavNode.h"
+#include "src/libxdata/world/graph/NavGraph.h"
 
 namespace xdata {
 
@@ -31,7 +31,7 @@ class RouteFinder {
 public:
     using EdgePtr = std::shared_ptr<NavEdge>;
     using NodePtr = std::shared_ptr<NavNode>;
-    using EdgeFilter = std::function<bool(const EdgePtr, const NodePtr)>;
+    using EdgeFilter = std::function<bool(const EdgePtr &, const NodePtr &)>;
 
     struct RouteDirection {
         EdgePtr via;
@@ -41,26 +41,48 @@ public:
         RouteDirection(EdgePtr via, NodePtr to): via(via), to(to) { }
     };
 
+    RouteFinder(std::shared_ptr<const NavGraph> graph);
+
+    // Airway edges must match the level mask before the filter is asked,
+    // procedure edges are only checked by the filter
+    void setLevelMask(uint8_t mask);
     void setEdgeFilter(EdgeFilter filter);
     void setAirwayChangePenalty(float percent);
     std::vector<RouteDirection> findRoute(NodePtr from, NodePtr to);
 
 private:
+    std::shared_ptr<const NavGraph> graph;
+    uint8_t levelMask = NavGraph::LEVEL_UPPER | NavGraph::LEVEL_LOWER;
     EdgeFilter edgeFilter;
     double directDistance = 0;
     float airwayChangePenalty = 0;
 
-    std::set<NodePtr> closedSet;
-    std::set<NodePtr> openSet;
-    std::map<NodePtr, RouteDirection> cameFrom;
-    std::map<NodePtr, double> gScore;
-    std::map<NodePtr, double> fScore;
+    // Nodes reached by the search get dense local indices in the order
+    // they are reached so that the per-search state stays small
+    struct NodeState {
+        int graphIdx;
+        int cameVia = -1; // edge index
+        int cameFrom = -1;
+        double gScore = std::numeric_limits<double>::infinity();
+        double fScore = std::numeric_limits<double>::infinity();
+        int heapPos = -1; // position in openHeap or -1 if not open
+        bool closed = false;
+    };
+
+    std::vector<NodeState> nodes;
+    std::vector<int> localIndex; // graph index -> index into nodes
+    std::vector<int> openHeap; // binary min-heap on fScore
+
+    int getIndex(int graphIdx);
+    void pushOrUpdateOpen(int idx);
+    int popLowestOpen();
+    void siftUp(size_t pos);
+    void siftDown(size_t pos);
+    void setHeapEntry(size_t pos, int idx);
 
-    NodePtr getLowestOpen();
-    double minCostHeuristic(NodePtr a, NodePtr b);
-    double cost(NodePtr a, const RouteDirection &dir);
-    double getGScore(NodePtr f);
-    std::vector<RouteDirection> reconstructPath(NodePtr lastFix);
+    double minCostHeuristic(int idx, const Location &goal);
+    double cost(int from, uint32_t conn);
+    std::vector<RouteDirection> reconstructPath(int lastIdx);
 };
 
 } /* namespace xdata */
@@ -0,0 +1,109 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cmath>
+#include <algorithm>
+#include "NodeGrid.h"
+
+namespace xdata {
+
+NodeGrid::NodeGrid(const std::vector<std::shared_ptr<NavNode>>& allNodes, int cellsPerDegree):
+    cellsPerDegree(cellsPerDegree),
+    rows(180 * cellsPerDegree),
+    columns(360 * cellsPerDegree)
+{
+    std::vector<std::pair<uint32_t, std::shared_ptr<NavNode>>> sorted;
+    sorted.reserve(allNodes.size());
+    for (auto &node: allNodes) {
+        auto &loc = node->getLocation();
+        if (!loc.isValid()) {
+            continue;
+        }
+        uint32_t cell = getRow(loc.latitude) * columns + getColumn(loc.longitude);
+        sorted.push_back(std::make_pair(cell, node));
+    }
+
+    // stable to keep the order of the nodes inside a cell
+    std::stable_sort(sorted.begin(), sorted.end(), [] (const auto &a, const auto &b) {
+        return a.first < b.first;
+    });
+
+    cellStart.resize(rows * columns + 1);
+    nodes.reserve(sorted.size());
+    size_t next = 0;
+    for (uint32_t cell = 0; cell < cellStart.size(); cell++) {
+        cellStart[cell] = next;
+        while (next < sorted.size() && sorted[next].first == cell) {
+            nodes.push_back(sorted[next].second);
+            next++;
+        }
+    }
+}
+
+size_t NodeGrid::getNodeCount() const {
+    return nodes.size();
+}
+
+int NodeGrid::getRow(double latitude) const {
+    int row = (int) std::floor((latitude + 90) * cellsPerDegree);
+    return std::max(0, std::min(rows - 1, row));
+}
+
+int NodeGrid::getColumn(double longitude) const {
+    double lon = longitude - 360 * std::floor((longitude + 180) / 360);
+    int col = (int) std::floor((lon + 180) * cellsPerDegree);
+    return std::max(0, std::min(columns - 1, col));
+}
+
+void NodeGrid::visitNodes(const Location& upLeft, const Location& lowRight, const NodeAcceptor& f) const {
+    if (!upLeft.isValid() || !lowRight.isValid()) {
+        return;
+    }
+
+    int firstRow = getRow(std::min(upLeft.latitude, lowRight.latitude));
+    int lastRow = getRow(std::max(upLeft.latitude, lowRight.latitude));
+
+    if (lowRight.longitude - upLeft.longitude >= 360) {
+        visitRows(firstRow, lastRow, 0, columns - 1, f);
+        return;
+    }
+
+    int firstColumn = getColumn(upLeft.longitude);
+    int lastColumn = getColumn(lowRight.longitude);
+    if (firstColumn <= lastColumn && lowRight.longitude >= upLeft.longitude) {
+        visitRows(firstRow, lastRow, firstColumn, lastColumn, f);
+    } else if (firstColumn > lastColumn) {
+        // across the antimeridian
+        visitRows(firstRow, lastRow, firstColumn, columns - 1, f);
+        visitRows(firstRow, lastRow, 0, lastColumn, f);
+    } else {
+        // both ends are in the same column, but the area wraps around the world
+        visitRows(firstRow, lastRow, 0, columns - 1, f);
+    }
+}
+
+void NodeGrid::visitRows(int firstRow, int lastRow, int firstColumn, int lastColumn, const NodeAcceptor& f) const {
+    for (int row = firstRow; row <= lastRow; row++) {
+        uint32_t begin = cellStart[row * columns + firstColumn];
+        uint32_t end = cellStart[row * columns + lastColumn + 1];
+        for (uint32_t i = begin; i < end; i++) {
+            f(*nodes[i]);
+        }
+    }
+}
+
+} /* namespace xdata */
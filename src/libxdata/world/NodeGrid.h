@@ -0,0 +1,58 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SRC_LIBXDATA_WORLD_NODEGRID_H_
+#define SRC_LIBXDATA_WORLD_NODEGRID_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <functional>
+#include "src/libxdata/world/graph/NavNode.h"
+
+namespace xdata {
+
+/*
+ * Immutable index to find the nav nodes in an area. The nodes are sorted
+ * by grid cell, row by row, so the cells of a row that lie in the queried
+ * longitude range form a single slice of the node array and a query only
+ * needs one lookup per row, no matter how many cells it covers.
+ * Longitudes are wrapped, so an area can extend across the antimeridian.
+ */
+class NodeGrid {
+public:
+    using NodeAcceptor = std::function<void(const NavNode &node)>;
+
+    NodeGrid(const std::vector<std::shared_ptr<NavNode>> &nodes, int cellsPerDegree);
+
+    size_t getNodeCount() const;
+    void visitNodes(const Location &upLeft, const Location &lowRight, const NodeAcceptor &f) const;
+
+private:
+    int cellsPerDegree;
+    int rows, columns;
+    std::vector<uint32_t> cellStart; // index of the first node of each cell, plus end
+    std::vector<std::shared_ptr<NavNode>> nodes;
+
+    int getRow(double latitude) const;
+    int getColumn(double longitude) const;
+    void visitRows(int firstRow, int lastRow, int firstColumn, int lastColumn, const NodeAcceptor &f) const;
+};
+
+} /* namespace xdata */
+
+#endif /* SRC_LIBXDATA_WORLD_NODEGRID_H_ */
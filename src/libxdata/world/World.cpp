@@ -130,40 +130,94 @@ void World::addFix(std::shared_ptr<Fix> fix) {
 }
 
 void World::registerNavNodes() {
-    for (auto it: airports) {
-        auto node = it.second;
-        auto &loc = node->getLocation();
-        int lat = (int) loc.latitude;
-        int lon = (int) loc.longitude;
+    std::vector<std::shared_ptr<NavNode>> airportNodes, userFixNodes, fixNodes;
 
-        allNodes[std::make_pair(lat, lon)].push_back(node);
+    for (auto it: airports) {
+        airportNodes.push_back(it.second);
     }
 
     for (auto it: fixes) {
-        auto node = it.second;
-        auto &loc = node->getLocation();
-        int lat = (int) loc.latitude;
-        int lon = (int) loc.longitude;
+        if (it.second->getUserFix()) {
+            userFixNodes.push_back(it.second);
+        } else {
+            fixNodes.push_back(it.second);
+        }
+    }
+
+    // Fixes are by far the densest layer, so they get a finer grid
+    auto newAirportGrid = std::make_shared<const NodeGrid>(airportNodes, 1);
+    auto newUserFixGrid = std::make_shared<const NodeGrid>(userFixNodes, 1);
+    auto newFixGrid = std::make_shared<const NodeGrid>(fixNodes, 4);
+
+    std::vector<std::shared_ptr<NavNode>> roots = airportNodes;
+    roots.insert(roots.end(), userFixNodes.begin(), userFixNodes.end());
+    roots.insert(roots.end(), fixNodes.begin(), fixNodes.end());
+
+    std::lock_guard<std::mutex> connectionLock(connectionMutex);
+    graphRoots = roots;
+    auto graph = std::make_shared<const NavGraph>(graphRoots);
+    logger::verbose("Nav graph has %d nodes", (int) graph->getNodeCount());
+
+    std::lock_guard<std::mutex> lock(indexMutex);
+    airportGrid = newAirportGrid;
+    userFixGrid = newUserFixGrid;
+    fixGrid = newFixGrid;
+    navGraph = graph;
+    navGraphStale = false;
+    indexVersion++;
+}
 
-        allNodes[std::make_pair(lat, lon)].push_back(node);
+std::shared_ptr<const NavGraph> World::getNavGraph() const {
+    {
+        std::lock_guard<std::mutex> lock(indexMutex);
+        if (!navGraphStale) {
+            return navGraph;
+        }
+    }
+
+    // the grids are not affected by connection changes, so only the graph is rebuilt
+    std::lock_guard<std::mutex> connectionLock(connectionMutex);
+    {
+        std::lock_guard<std::mutex> lock(indexMutex);
+        if (!navGraphStale) {
+            return navGraph;
+        }
     }
+
+    auto graph = std::make_shared<const NavGraph>(graphRoots);
+    logger::verbose("Rebuilt nav graph with %d nodes", (int) graph->getNodeCount());
+
+    std::lock_guard<std::mutex> lock(indexMutex);
+    navGraph = graph;
+    navGraphStale = false;
+    return graph;
 }
 
-void World::visitNodes(const Location& upLeft, const Location& lowRight, NodeAcceptor f) {
-    int lat1 = (int) std::ceil(std::min(90.0, upLeft.latitude));
-    int lat2 = (int) std::floor(std::max(-90.0, lowRight.latitude));
-    int lon1 = (int) std::floor(std::max(-180.0, upLeft.longitude));
-    int lon2 = (int) std::ceil(std::min(180.0, lowRight.longitude));
+void World::changeConnections(std::function<void()> f) {
+    std::lock_guard<std::mutex> connectionLock(connectionMutex);
+    f();
 
-    for (int lat = lat2; lat <= lat1; lat++) {
-        for (int lon = lon1; lon <= lon2; lon++) {
-            auto it = allNodes.find(std::make_pair(lat, lon));
-            if (it == allNodes.end()) {
-                continue;
-            }
-            for (auto node: it->second) {
-                f(*node);
-            }
+    std::lock_guard<std::mutex> lock(indexMutex);
+    navGraphStale = true;
+}
+
+uint64_t World::getIndexVersion() const {
+    std::lock_guard<std::mutex> lock(indexMutex);
+    return indexVersion;
+}
+
+void World::visitNodes(const Location& upLeft, const Location& lowRight, NodeAcceptor f, int layers) {
+    std::shared_ptr<const NodeGrid> grids[3];
+    {
+        std::lock_guard<std::mutex> lock(indexMutex);
+        grids[0] = (layers & LAYER_AIRPORTS) ? airportGrid : nullptr;
+        grids[1] = (layers & LAYER_USER_FIXES) ? userFixGrid : nullptr;
+        grids[2] = (layers & LAYER_FIXES) ? fixGrid : nullptr;
+    }
+
+    for (auto &grid: grids) {
+        if (grid) {
+            grid->visitNodes(upLeft, lowRight, f);
         }
     }
 }
@@ -23,10 +23,13 @@
 #include <memory>
 #include <functional>
 #include <atomic>
+#include <mutex>
 #include "src/libxdata/world/models/airport/Airport.h"
 #include "src/libxdata/world/models/navaids/Fix.h"
 #include "src/libxdata/world/models/Region.h"
 #include "src/libxdata/world/models/Airway.h"
+#include "src/libxdata/world/graph/NavGraph.h"
+#include "src/libxdata/world/NodeGrid.h"
 
 namespace xdata {
 
@@ -36,7 +39,13 @@ constexpr const double M_TO_FT = 3.28084;
 class World {
 public:
     static constexpr const int MAX_SEARCH_RESULTS = 10;
-    using NodeAcceptor = std::function<void(const NavNode &node)>;
+    using NodeAcceptor = NodeGrid::NodeAcceptor;
+
+    // Node layers for visitNodes, ordered by importance
+    static constexpr const int LAYER_AIRPORTS = 1;
+    static constexpr const int LAYER_USER_FIXES = 2;
+    static constexpr const int LAYER_FIXES = 4;
+    static constexpr const int LAYER_ALL = LAYER_AIRPORTS | LAYER_USER_FIXES | LAYER_FIXES;
 
     World();
 
@@ -54,7 +63,16 @@ public:
     bool shouldCancelLoading() const;
 
     void registerNavNodes();
-    void visitNodes(const Location &upLeft, const Location &lowRight, NodeAcceptor f);
+    void visitNodes(const Location &upLeft, const Location &lowRight, NodeAcceptor f, int layers = LAYER_ALL);
+
+    // Rebuilt by registerNavNodes, and on the next call after connections were changed
+    std::shared_ptr<const NavGraph> getNavGraph() const;
+
+    // For changes to the node connections after registerNavNodes, e.g. when adding procedures
+    void changeConnections(std::function<void()> f);
+
+    // Changes whenever registerNavNodes replaced the indexes, e.g. to redraw cached overlays
+    uint64_t getIndexVersion() const;
 
 private:
     std::atomic_bool loadCancelled { false };
@@ -69,8 +87,20 @@ private:
     // Unique within airway level
     std::multimap<std::string, std::shared_ptr<Airway>> airways;
 
+    // Rebuilt by registerNavNodes, replaced while the old ones might still be in use
+    mutable std::mutex indexMutex;
+
     // To search by location
-    std::map<std::pair<int, int>, std::vector<std::shared_ptr<NavNode>>> allNodes;
+    std::shared_ptr<const NodeGrid> airportGrid, userFixGrid, fixGrid;
+
+    // To route
+    mutable std::shared_ptr<const NavGraph> navGraph;
+    mutable bool navGraphStale = false;
+    uint64_t indexVersion = 0;
+
+    // Guards the node connections and the graph roots, locked before indexMutex
+    mutable std::mutex connectionMutex;
+    std::vector<std::shared_ptr<NavNode>> graphRoots;
 };
 
 
@@ -0,0 +1,139 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "NavGraph.h"
+
+namespace xdata {
+
+NavGraph::NavGraph(const std::vector<std::shared_ptr<NavNode>>& roots) {
+    for (auto &node: roots) {
+        addNode(node);
+    }
+
+    std::unordered_map<const NavEdge *, int> edgeIndex;
+
+    // nodes reached through connections are appended while iterating
+    offsets.push_back(0);
+    for (size_t i = 0; i < nodes.size(); i++) {
+        for (auto &conn: nodes[i]->getConnections()) {
+            auto &edge = std::get<0>(conn);
+            auto &neighbor = std::get<1>(conn);
+            if (!edge || !neighbor) {
+                continue;
+            }
+
+            auto it = edgeIndex.find(edge.get());
+            if (it == edgeIndex.end()) {
+                it = edgeIndex.emplace(edge.get(), edges.size()).first;
+                edges.push_back(edge);
+            }
+
+            uint8_t level = 0;
+            if (edge->isProcedure()) {
+                level |= PROCEDURE;
+            }
+            if (edge->supportsLevel(AirwayLevel::UPPER)) {
+                level |= LEVEL_UPPER;
+            }
+            if (edge->supportsLevel(AirwayLevel::LOWER)) {
+                level |= LEVEL_LOWER;
+            }
+
+            int neighborIdx = addNode(neighbor);
+            neighbors.push_back(neighborIdx);
+            edgeIndices.push_back(it->second);
+            lengths.push_back(locations[i].distanceTo(locations[neighborIdx]));
+            levels.push_back(level);
+        }
+        offsets.push_back(neighbors.size());
+    }
+
+    nodes.shrink_to_fit();
+    locations.shrink_to_fit();
+    edges.shrink_to_fit();
+}
+
+int NavGraph::addNode(const std::shared_ptr<NavNode>& node) {
+    auto it = nodeIndex.find(node.get());
+    if (it != nodeIndex.end()) {
+        return it->second;
+    }
+
+    int idx = nodes.size();
+    nodes.push_back(node);
+    locations.push_back(node->getLocation());
+    nodeIndex.emplace(node.get(), idx);
+    return idx;
+}
+
+uint8_t NavGraph::getLevelMask(AirwayLevel level) {
+    switch (level) {
+    case AirwayLevel::UPPER:    return LEVEL_UPPER;
+    case AirwayLevel::LOWER:    return LEVEL_LOWER;
+    default:                    return 0;
+    }
+}
+
+size_t NavGraph::getNodeCount() const {
+    return nodes.size();
+}
+
+int NavGraph::getIndex(const NavNode* node) const {
+    auto it = nodeIndex.find(node);
+    if (it == nodeIndex.end()) {
+        return -1;
+    }
+    return it->second;
+}
+
+const std::shared_ptr<NavNode>& NavGraph::getNode(int idx) const {
+    return nodes[idx];
+}
+
+const Location& NavGraph::getLocation(int idx) const {
+    return locations[idx];
+}
+
+uint32_t NavGraph::getFirstConnection(int idx) const {
+    return offsets[idx];
+}
+
+uint32_t NavGraph::getEndConnection(int idx) const {
+    return offsets[idx + 1];
+}
+
+int NavGraph::getNeighbor(uint32_t conn) const {
+    return neighbors[conn];
+}
+
+int NavGraph::getEdgeIndex(uint32_t conn) const {
+    return edgeIndices[conn];
+}
+
+double NavGraph::getLength(uint32_t conn) const {
+    return lengths[conn];
+}
+
+uint8_t NavGraph::getLevels(uint32_t conn) const {
+    return levels[conn];
+}
+
+const std::shared_ptr<NavEdge>& NavGraph::getEdge(int edgeIdx) const {
+    return edges[edgeIdx];
+}
+
+} /* namespace xdata */
@@ -0,0 +1,79 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SRC_LIBXDATA_WORLD_GRAPH_NAVGRAPH_H_
+#define SRC_LIBXDATA_WORLD_GRAPH_NAVGRAPH_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include "NavNode.h"
+
+namespace xdata {
+
+/*
+ * Immutable snapshot of the connections between the nav nodes in
+ * compressed sparse row form: the connections of node i are the entries
+ * [getFirstConnection(i), getFirstConnection(i + 1)) of the flat
+ * neighbor, edge, length and level arrays. Nodes and edges are referred
+ * to by dense indices, so traversals don't need to touch the shared
+ * pointers of the nodes.
+ */
+class NavGraph {
+public:
+    static constexpr const uint8_t LEVEL_UPPER = 1;
+    static constexpr const uint8_t LEVEL_LOWER = 2;
+    static constexpr const uint8_t PROCEDURE = 4;
+
+    // Contains the given nodes and all nodes reachable from them
+    NavGraph(const std::vector<std::shared_ptr<NavNode>> &roots);
+
+    static uint8_t getLevelMask(AirwayLevel level);
+
+    size_t getNodeCount() const;
+    int getIndex(const NavNode *node) const; // -1 if not in graph
+    const std::shared_ptr<NavNode> &getNode(int idx) const;
+    const Location &getLocation(int idx) const;
+
+    uint32_t getFirstConnection(int idx) const;
+    uint32_t getEndConnection(int idx) const;
+    int getNeighbor(uint32_t conn) const;
+    int getEdgeIndex(uint32_t conn) const;
+    double getLength(uint32_t conn) const;
+    uint8_t getLevels(uint32_t conn) const;
+    const std::shared_ptr<NavEdge> &getEdge(int edgeIdx) const;
+
+private:
+    std::vector<std::shared_ptr<NavNode>> nodes;
+    std::vector<Location> locations;
+    std::unordered_map<const NavNode *, int> nodeIndex;
+
+    std::vector<std::shared_ptr<NavEdge>> edges;
+
+    std::vector<uint32_t> offsets;
+    std::vector<int> neighbors;
+    std::vector<int> edgeIndices;
+    std::vector<double> lengths;
+    std::vector<uint8_t> levels;
+
+    int addNode(const std::shared_ptr<NavNode> &node);
+};
+
+} /* namespace xdata */
+
+#endif /* SRC_LIBXDATA_WORLD_GRAPH_NAVGRAPH_H_ */
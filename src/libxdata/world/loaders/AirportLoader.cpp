@@ -28,8 +28,24 @@ AirportLoader::AirportLoader(std::shared_ptr<World> worldPtr):
 }
 
 void AirportLoader::load(const std::string& file) const {
+    apply(parse(file));
+}
+
+std::vector<AirportData> AirportLoader::parse(const std::string& file) const {
+    std::vector<AirportData> res;
     AirportParser parser(file);
-    parser.setAcceptor([this] (const AirportData &data) {
+    parser.setAcceptor([this, &res] (const AirportData &data) {
+        res.push_back(data);
+        if (world->shouldCancelLoading()) {
+            throw std::runtime_error("Cancelled");
+        }
+    });
+    parser.loadAirports();
+    return res;
+}
+
+void AirportLoader::apply(const std::vector<AirportData>& entries) const {
+    for (auto &data: entries) {
         try {
             onAirportLoaded(data);
         } catch (const std::exception &e) {
@@ -38,8 +54,7 @@ void AirportLoader::load(const std::string& file) const {
         if (world->shouldCancelLoading()) {
             throw std::runtime_error("Cancelled");
         }
-    });
-    parser.loadAirports();
+    }
 }
 
 void AirportLoader::onAirportLoaded(const AirportData& port) const {
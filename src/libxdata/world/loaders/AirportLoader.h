@@ -19,6 +19,7 @@
 #define SRC_LIBXDATA_LOADERS_AIRPORTLOADER_H_
 
 #include <memory>
+#include <vector>
 #include "src/libxdata/parsers/objects/AirportData.h"
 #include "src/libxdata/parsers/AirportParser.h"
 #include "src/libxdata/world/World.h"
@@ -29,6 +30,10 @@ class AirportLoader {
 public:
     AirportLoader(std::shared_ptr<World> worldPtr);
     void load(const std::string &file) const;
+
+    // Entries for airports that already exist (custom scenery comes first) only patch the runway surfaces
+    std::vector<AirportData> parse(const std::string &file) const;
+    void apply(const std::vector<AirportData> &entries) const;
 private:
     std::shared_ptr<World> world;
 
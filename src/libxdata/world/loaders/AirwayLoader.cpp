@@ -27,8 +27,24 @@ AirwayLoader::AirwayLoader(std::shared_ptr<World> worldPtr):
 }
 
 void AirwayLoader::load(const std::string& file) {
+    apply(parse(file));
+}
+
+std::vector<AirwayData> AirwayLoader::parse(const std::string& file) const {
+    std::vector<AirwayData> res;
     AirwayParser parser(file);
-    parser.setAcceptor([this] (const AirwayData &data) {
+    parser.setAcceptor([this, &res] (const AirwayData &data) {
+        res.push_back(data);
+        if (world->shouldCancelLoading()) {
+            throw std::runtime_error("Cancelled");
+        }
+    });
+    parser.loadAirways();
+    return res;
+}
+
+void AirwayLoader::apply(const std::vector<AirwayData>& entries) {
+    for (auto &data: entries) {
         try {
             onAirwayLoaded(data);
         } catch (const std::exception &e) {
@@ -37,8 +53,7 @@ void AirwayLoader::load(const std::string& file) {
         if (world->shouldCancelLoading()) {
             throw std::runtime_error("Cancelled");
         }
-    });
-    parser.loadAirways();
+    }
 }
 
 void AirwayLoader::onAirwayLoaded(const AirwayData& airway) {
@@ -19,6 +19,7 @@
 #define SRC_LIBXDATA_LOADERS_AIRWAYLOADER_H_
 
 #include <memory>
+#include <vector>
 #include "src/libxdata/parsers/objects/AirwayData.h"
 #include "src/libxdata/parsers/AirwayParser.h"
 #include "src/libxdata/world/World.h"
@@ -29,6 +30,10 @@ class AirwayLoader {
 public:
     AirwayLoader(std::shared_ptr<World> worldPtr);
     void load(const std::string &file);
+
+    // Airway segments connect existing fixes and navaids, so apply() must run after both
+    std::vector<AirwayData> parse(const std::string &file) const;
+    void apply(const std::vector<AirwayData> &entries);
 private:
     std::shared_ptr<World> world;
 
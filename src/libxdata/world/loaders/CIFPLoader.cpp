@@ -27,8 +27,24 @@ CIFPLoader::CIFPLoader(std::shared_ptr<World> worldPtr):
 }
 
 void CIFPLoader::load(std::shared_ptr<Airport> airport, const std::string& file) {
+    apply(airport, parse(file));
+}
+
+std::vector<CIFPData> CIFPLoader::parse(const std::string& file) const {
+    std::vector<CIFPData> res;
     CIFPParser parser(file);
-    parser.setAcceptor([this, airport] (const CIFPData &cifp) {
+    parser.setAcceptor([this, &res] (const CIFPData &cifp) {
+        res.push_back(cifp);
+        if (world->shouldCancelLoading()) {
+            throw std::runtime_error("Cancelled");
+        }
+    });
+    parser.loadCIFP();
+    return res;
+}
+
+void CIFPLoader::apply(std::shared_ptr<Airport> airport, const std::vector<CIFPData>& procedures) {
+    for (auto &cifp: procedures) {
         try {
             onProcedureLoaded(airport, cifp);
         } catch (const std::exception &e) {
@@ -37,8 +53,7 @@ void CIFPLoader::load(std::shared_ptr<Airport> airport, const std::string& file)
         if (world->shouldCancelLoading()) {
             throw std::runtime_error("Cancelled");
         }
-    });
-    parser.loadCIFP();
+    }
 }
 
 void CIFPLoader::onProcedureLoaded(std::shared_ptr<Airport> airport, const CIFPData& procedure) {
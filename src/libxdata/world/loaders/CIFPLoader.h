@@ -19,6 +19,7 @@
 #define SRC_LIBXDATA_LOADERS_CIFPLOADER_H_
 
 #include <memory>
+#include <vector>
 #include "src/libxdata/parsers/objects/CIFPData.h"
 #include "src/libxdata/world/models/airport/Airport.h"
 #include "src/libxdata/world/World.h"
@@ -29,6 +30,10 @@ class CIFPLoader {
 public:
     CIFPLoader(std::shared_ptr<World> worldPtr);
     void load(std::shared_ptr<Airport> airport, const std::string &file);
+
+    // Procedures refer to the airport's runways and terminal fixes
+    std::vector<CIFPData> parse(const std::string &file) const;
+    void apply(std::shared_ptr<Airport> airport, const std::vector<CIFPData> &procedures);
 private:
     std::shared_ptr<World> world;
 
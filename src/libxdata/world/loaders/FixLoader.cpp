@@ -27,8 +27,24 @@ FixLoader::FixLoader(std::shared_ptr<World> worldPtr):
 }
 
 void FixLoader::load(const std::string& file) {
+    apply(parse(file));
+}
+
+std::vector<FixData> FixLoader::parse(const std::string& file) const {
+    std::vector<FixData> res;
     FixParser parser(file);
-    parser.setAcceptor([this] (const FixData &data) {
+    parser.setAcceptor([this, &res] (const FixData &data) {
+        res.push_back(data);
+        if (world->shouldCancelLoading()) {
+            throw std::runtime_error("Cancelled");
+        }
+    });
+    parser.loadFixes();
+    return res;
+}
+
+void FixLoader::apply(const std::vector<FixData>& entries) {
+    for (auto &data: entries) {
         try {
             onFixLoaded(data);
         } catch (const std::exception &e) {
@@ -37,8 +53,7 @@ void FixLoader::load(const std::string& file) {
         if (world->shouldCancelLoading()) {
             throw std::runtime_error("Cancelled");
         }
-    });
-    parser.loadFixes();
+    }
 }
 
 void FixLoader::onFixLoaded(const FixData& fix) {
@@ -19,6 +19,7 @@
 #define SRC_LIBXDATA_LOADERS_FIXLOADER_H_
 
 #include <memory>
+#include <vector>
 #include "src/libxdata/parsers/FixParser.h"
 #include "src/libxdata/world/World.h"
 
@@ -28,6 +29,10 @@ class FixLoader {
 public:
     FixLoader(std::shared_ptr<World> worldPtr);
     void load(const std::string &file);
+
+    // Terminal fixes are attached to their airports, so apply() must run after the airports
+    std::vector<FixData> parse(const std::string &file) const;
+    void apply(const std::vector<FixData> &entries);
 private:
     std::shared_ptr<World> world;
 
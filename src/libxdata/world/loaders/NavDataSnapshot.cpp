@@ -0,0 +1,420 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cstring>
+#include <stdexcept>
+#include "NavDataSnapshot.h"
+#include "src/Logger.h"
+
+namespace xdata {
+
+NavDataSnapshot::NavDataSnapshot(const std::string& utf8Path):
+    snapshotPath(utf8Path),
+    tempPath(utf8Path + ".tmp")
+{
+}
+
+void NavDataSnapshot::addSourceFile(const std::string& utf8Path) {
+    auto path = fs::u8path(utf8Path);
+    std::error_code ec;
+
+    Source src;
+    src.utf8Path = utf8Path;
+    src.size = fs::file_size(path, ec);
+    if (ec) {
+        src.size = 0;
+    }
+    src.modTime = fs::last_write_time(path, ec).time_since_epoch().count();
+    if (ec) {
+        src.modTime = 0;
+    }
+    sources.push_back(src);
+}
+
+bool NavDataSnapshot::open() {
+    in.open(fs::u8path(snapshotPath), std::ios::in | std::ios::binary);
+    if (!in) {
+        return false;
+    }
+
+    try {
+        return readHeader();
+    } catch (const std::exception &e) {
+        logger::warn("Invalid nav data snapshot: %s", e.what());
+        return false;
+    }
+}
+
+bool NavDataSnapshot::readHeader() {
+    // the end marker is only written after everything else
+    in.seekg(-4, std::ios::end);
+    if (readU32() != END_MAGIC) {
+        return false;
+    }
+    in.seekg(0, std::ios::beg);
+
+    if (readU32() != SNAPSHOT_MAGIC || readU32() != VERSION) {
+        return false;
+    }
+
+    if (readU32() != sources.size()) {
+        return false;
+    }
+
+    for (auto &src: sources) {
+        if (readString() != src.utf8Path || readU64() != src.size || readU64() != src.modTime) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::vector<std::vector<AirportData>> NavDataSnapshot::readAirports() {
+    std::vector<std::vector<AirportData>> res(readU32());
+    for (auto &airports: res) {
+        airports = readList(&NavDataSnapshot::readAirport);
+    }
+    return res;
+}
+
+std::vector<FixData> NavDataSnapshot::readFixes() {
+    return readList(&NavDataSnapshot::readFix);
+}
+
+std::vector<NavaidData> NavDataSnapshot::readNavaids() {
+    return readList(&NavDataSnapshot::readNavaid);
+}
+
+std::vector<AirwayData> NavDataSnapshot::readAirways() {
+    return readList(&NavDataSnapshot::readAirway);
+}
+
+void NavDataSnapshot::create() {
+    platform::mkpath(platform::getDirNameFromPath(snapshotPath));
+
+    out.open(fs::u8path(tempPath), std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!out) {
+        throw std::runtime_error("Couldn't create nav data snapshot " + tempPath);
+    }
+    writing = true;
+    writeHeader();
+}
+
+void NavDataSnapshot::writeHeader() {
+    writeU32(SNAPSHOT_MAGIC);
+    writeU32(VERSION);
+    writeU32(sources.size());
+    for (auto &src: sources) {
+        writeString(src.utf8Path);
+        writeU64(src.size);
+        writeU64(src.modTime);
+    }
+}
+
+void NavDataSnapshot::writeAirports(const std::vector<std::vector<AirportData>>& airportFiles) {
+    writeU32(airportFiles.size());
+    for (auto &airports: airportFiles) {
+        writeList(airports, &NavDataSnapshot::writeAirport);
+    }
+}
+
+void NavDataSnapshot::writeFixes(const std::vector<FixData>& fixes) {
+    writeList(fixes, &NavDataSnapshot::writeFix);
+}
+
+void NavDataSnapshot::writeNavaids(const std::vector<NavaidData>& navaids) {
+    writeList(navaids, &NavDataSnapshot::writeNavaid);
+}
+
+void NavDataSnapshot::writeAirways(const std::vector<AirwayData>& airways) {
+    writeList(airways, &NavDataSnapshot::writeAirway);
+}
+
+void NavDataSnapshot::finish() {
+    writeU32(END_MAGIC);
+    out.close();
+    writing = false;
+
+    if (!out) {
+        platform::removeFile(tempPath);
+        throw std::runtime_error("Couldn't write nav data snapshot " + tempPath);
+    }
+
+    fs::rename(fs::u8path(tempPath), fs::u8path(snapshotPath));
+}
+
+NavDataSnapshot::~NavDataSnapshot() {
+    if (writing) {
+        // cancelled or failed while loading
+        out.close();
+        try {
+            platform::removeFile(tempPath);
+        } catch (const std::exception &e) {
+            logger::warn("Couldn't remove incomplete nav data snapshot: %s", e.what());
+        }
+    }
+}
+
+uint8_t NavDataSnapshot::readU8() {
+    char c;
+    if (!in.get(c)) {
+        throw std::runtime_error("Truncated nav data snapshot");
+    }
+    return c;
+}
+
+uint32_t NavDataSnapshot::readU32() {
+    uint8_t buf[4];
+    if (!in.read(reinterpret_cast<char *>(buf), sizeof(buf))) {
+        throw std::runtime_error("Truncated nav data snapshot");
+    }
+    return buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((uint32_t) buf[3] << 24);
+}
+
+uint64_t NavDataSnapshot::readU64() {
+    uint64_t low = readU32();
+    return low | ((uint64_t) readU32() << 32);
+}
+
+double NavDataSnapshot::readDouble() {
+    uint64_t bits = readU64();
+    double v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+std::string NavDataSnapshot::readString() {
+    std::string str(readU32(), '\0');
+    if (!str.empty() && !in.read(&str[0], str.size())) {
+        throw std::runtime_error("Truncated nav data snapshot");
+    }
+    return str;
+}
+
+void NavDataSnapshot::writeU8(uint8_t v) {
+    out.put(v);
+}
+
+void NavDataSnapshot::writeU32(uint32_t v) {
+    uint8_t buf[4] = {uint8_t(v), uint8_t(v >> 8), uint8_t(v >> 16), uint8_t(v >> 24)};
+    out.write(reinterpret_cast<const char *>(buf), sizeof(buf));
+}
+
+void NavDataSnapshot::writeU64(uint64_t v) {
+    writeU32(v & 0xFFFFFFFF);
+    writeU32(v >> 32);
+}
+
+void NavDataSnapshot::writeDouble(double v) {
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    writeU64(bits);
+}
+
+void NavDataSnapshot::writeString(const std::string& str) {
+    writeU32(str.size());
+    out.write(str.data(), str.size());
+}
+
+AirportData NavDataSnapshot::readAirport() {
+    AirportData airport;
+    airport.id = readString();
+    airport.name = readString();
+    airport.elevation = readU32();
+    airport.icaoCode = readString();
+    airport.latitude = readDouble();
+    airport.longitude = readDouble();
+    airport.region = readString();
+    airport.country = readString();
+
+    airport.frequencies.resize(readU32());
+    for (auto &frq: airport.frequencies) {
+        frq.code = readU32();
+        frq.desc = readString();
+        frq.frq = readU32();
+    }
+
+    airport.runways.resize(readU32());
+    for (auto &rwy: airport.runways) {
+        rwy.width = readDouble();
+        rwy.surfaceType = readU32();
+        rwy.ends.resize(readU32());
+        for (auto &end: rwy.ends) {
+            end.name = readString();
+            end.latitude = readDouble();
+            end.longitude = readDouble();
+            end.displace = readDouble();
+        }
+    }
+
+    airport.heliports.resize(readU32());
+    for (auto &heliport: airport.heliports) {
+        heliport.name = readString();
+        heliport.latitude = readDouble();
+        heliport.longitude = readDouble();
+        heliport.surfaceType = readU32();
+    }
+
+    return airport;
+}
+
+void NavDataSnapshot::writeAirport(const AirportData& airport) {
+    writeString(airport.id);
+    writeString(airport.name);
+    writeU32(airport.elevation);
+    writeString(airport.icaoCode);
+    writeDouble(airport.latitude);
+    writeDouble(airport.longitude);
+    writeString(airport.region);
+    writeString(airport.country);
+
+    writeU32(airport.frequencies.size());
+    for (auto &frq: airport.frequencies) {
+        writeU32(frq.code);
+        writeString(frq.desc);
+        writeU32(frq.frq);
+    }
+
+    writeU32(airport.runways.size());
+    for (auto &rwy: airport.runways) {
+        writeDouble(rwy.width);
+        writeU32(rwy.surfaceType);
+        writeU32(rwy.ends.size());
+        for (auto &end: rwy.ends) {
+            writeString(end.name);
+            writeDouble(end.latitude);
+            writeDouble(end.longitude);
+            writeDouble(end.displace);
+        }
+    }
+
+    writeU32(airport.heliports.size());
+    for (auto &heliport: airport.heliports) {
+        writeString(heliport.name);
+        writeDouble(heliport.latitude);
+        writeDouble(heliport.longitude);
+        writeU32(heliport.surfaceType);
+    }
+}
+
+FixData NavDataSnapshot::readFix() {
+    FixData fix;
+    fix.id = readString();
+    fix.latitude = readDouble();
+    fix.longitude = readDouble();
+    fix.terminalAreaId = readString();
+    fix.icaoRegion = readString();
+    fix.col27 = readU8();
+    fix.col28 = readU8();
+    fix.col29 = readU8();
+    return fix;
+}
+
+void NavDataSnapshot::writeFix(const FixData& fix) {
+    writeString(fix.id);
+    writeDouble(fix.latitude);
+    writeDouble(fix.longitude);
+    writeString(fix.terminalAreaId);
+    writeString(fix.icaoRegion);
+    writeU8(fix.col27);
+    writeU8(fix.col28);
+    writeU8(fix.col29);
+}
+
+NavaidData NavDataSnapshot::readNavaid() {
+    NavaidData navaid;
+    navaid.type = (NavaidData::Type) readU32();
+    navaid.latitude = readDouble();
+    navaid.longitude = readDouble();
+    navaid.elevation = readU32();
+    navaid.radio = readU32();
+    navaid.range = readU32();
+    navaid.bearing = readDouble();
+    navaid.bearingMagnetic = readDouble();
+    navaid.id = readString();
+    navaid.terminalRegion = readString();
+    navaid.icaoRegion = readString();
+    navaid.name = readString();
+    return navaid;
+}
+
+void NavDataSnapshot::writeNavaid(const NavaidData& navaid) {
+    writeU32((uint32_t) navaid.type);
+    writeDouble(navaid.latitude);
+    writeDouble(navaid.longitude);
+    writeU32(navaid.elevation);
+    writeU32(navaid.radio);
+    writeU32(navaid.range);
+    writeDouble(navaid.bearing);
+    writeDouble(navaid.bearingMagnetic);
+    writeString(navaid.id);
+    writeString(navaid.terminalRegion);
+    writeString(navaid.icaoRegion);
+    writeString(navaid.name);
+}
+
+AirwayData NavDataSnapshot::readAirway() {
+    AirwayData airway;
+    airway.beginID = readString();
+    airway.beginIcaoRegion = readString();
+    airway.beginType = (AirwayData::NavType) readU32();
+    airway.endID = readString();
+    airway.endIcaoRegion = readString();
+    airway.endType = (AirwayData::NavType) readU32();
+    airway.dirRestriction = (AirwayData::DirectionRestriction) readU32();
+    airway.level = (AirwayData::AltitudeLevel) readU32();
+    airway.base = readU32();
+    airway.top = readU32();
+    airway.name = readString();
+    return airway;
+}
+
+void NavDataSnapshot::writeAirway(const AirwayData& airway) {
+    writeString(airway.beginID);
+    writeString(airway.beginIcaoRegion);
+    writeU32((uint32_t) airway.beginType);
+    writeString(airway.endID);
+    writeString(airway.endIcaoRegion);
+    writeU32((uint32_t) airway.endType);
+    writeU32((uint32_t) airway.dirRestriction);
+    writeU32((uint32_t) airway.level);
+    writeU32(airway.base);
+    writeU32(airway.top);
+    writeString(airway.name);
+}
+
+template<typename T>
+std::vector<T> NavDataSnapshot::readList(T (NavDataSnapshot::*readItem)()) {
+    uint32_t count = readU32();
+    std::vector<T> list;
+    list.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        list.push_back((this->*readItem)());
+    }
+    return list;
+}
+
+template<typename T>
+void NavDataSnapshot::writeList(const std::vector<T>& list, void (NavDataSnapshot::*writeItem)(const T &)) {
+    writeU32(list.size());
+    for (auto &item: list) {
+        (this->*writeItem)(item);
+    }
+}
+
+} /* namespace xdata */
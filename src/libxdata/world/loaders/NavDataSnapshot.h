@@ -0,0 +1,120 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SRC_LIBXDATA_LOADERS_NAVDATASNAPSHOT_H_
+#define SRC_LIBXDATA_LOADERS_NAVDATASNAPSHOT_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "src/libxdata/parsers/objects/AirportData.h"
+#include "src/libxdata/parsers/objects/FixData.h"
+#include "src/libxdata/parsers/objects/NavaidData.h"
+#include "src/libxdata/parsers/objects/AirwayData.h"
+#include "src/platform/Platform.h"
+
+namespace xdata {
+
+/*
+ * Stores the parsed records of the text nav data files in a single binary
+ * file so that later starts can build the world without running the text
+ * parsers. The snapshot is only used if its version and the list of source
+ * files including their sizes and modification times match, otherwise it
+ * is rebuilt while loading the text files.
+ *
+ * Layout: "AVNS", u32 version, u32 sourceCount, sources of
+ *         string path, u64 size, u64 mtime
+ *         then airport files, fixes, navaids and airways, then "AVNE".
+ *
+ * The CIFP procedures are not part of the snapshot because they are only
+ * loaded on demand, see Airport::loadProcedures.
+ *
+ * Strings and lists are prefixed with their u32 length, all integers are
+ * little endian. The snapshot is written to a temporary file that only
+ * replaces the old snapshot when it is complete.
+ */
+class NavDataSnapshot {
+public:
+    NavDataSnapshot(const std::string &utf8Path);
+
+    // The sources must be added in the same order for every load
+    void addSourceFile(const std::string &utf8Path);
+
+    // Returns false if the snapshot is missing or outdated
+    bool open();
+    std::vector<std::vector<AirportData>> readAirports();
+    std::vector<FixData> readFixes();
+    std::vector<NavaidData> readNavaids();
+    std::vector<AirwayData> readAirways();
+
+    void create();
+    void writeAirports(const std::vector<std::vector<AirportData>> &airportFiles);
+    void writeFixes(const std::vector<FixData> &fixes);
+    void writeNavaids(const std::vector<NavaidData> &navaids);
+    void writeAirways(const std::vector<AirwayData> &airways);
+    void finish();
+
+    ~NavDataSnapshot();
+private:
+    static constexpr const uint32_t SNAPSHOT_MAGIC = 0x534E5641; // "AVNS"
+    static constexpr const uint32_t END_MAGIC = 0x454E5641; // "AVNE"
+    static constexpr const uint32_t VERSION = 2;
+
+    struct Source {
+        std::string utf8Path;
+        uint64_t size;
+        uint64_t modTime;
+    };
+
+    std::string snapshotPath, tempPath;
+    std::vector<Source> sources;
+    fs::ifstream in;
+    fs::ofstream out;
+    bool writing = false;
+
+    bool readHeader();
+    void writeHeader();
+
+    uint8_t readU8();
+    uint32_t readU32();
+    uint64_t readU64();
+    double readDouble();
+    std::string readString();
+    void writeU8(uint8_t v);
+    void writeU32(uint32_t v);
+    void writeU64(uint64_t v);
+    void writeDouble(double v);
+    void writeString(const std::string &str);
+
+    AirportData readAirport();
+    void writeAirport(const AirportData &airport);
+    FixData readFix();
+    void writeFix(const FixData &fix);
+    NavaidData readNavaid();
+    void writeNavaid(const NavaidData &navaid);
+    AirwayData readAirway();
+    void writeAirway(const AirwayData &airway);
+
+    template<typename T>
+    std::vector<T> readList(T (NavDataSnapshot::*readItem)());
+    template<typename T>
+    void writeList(const std::vector<T> &list, void (NavDataSnapshot::*writeItem)(const T &));
+};
+
+} /* namespace xdata */
+
+#endif /* SRC_LIBXDATA_LOADERS_NAVDATASNAPSHOT_H_ */
@@ -28,8 +28,24 @@ NavaidLoader::NavaidLoader(std::shared_ptr<World> worldPtr):
 }
 
 void NavaidLoader::load(const std::string& file) {
+    apply(parse(file));
+}
+
+std::vector<NavaidData> NavaidLoader::parse(const std::string& file) const {
+    std::vector<NavaidData> res;
     NavaidParser parser(file);
-    parser.setAcceptor([this] (const NavaidData &data) {
+    parser.setAcceptor([this, &res] (const NavaidData &data) {
+        res.push_back(data);
+        if (world->shouldCancelLoading()) {
+            throw std::runtime_error("Cancelled");
+        }
+    });
+    parser.loadNavaids();
+    return res;
+}
+
+void NavaidLoader::apply(const std::vector<NavaidData>& entries) {
+    for (auto &data: entries) {
         try {
             onNavaidLoaded(data);
         } catch (const std::exception &e) {
@@ -38,8 +54,7 @@ void NavaidLoader::load(const std::string& file) {
         if (world->shouldCancelLoading()) {
             throw std::runtime_error("Cancelled");
         }
-    });
-    parser.loadNavaids();
+    }
 }
 
 void NavaidLoader::onNavaidLoaded(const NavaidData& navaid) {
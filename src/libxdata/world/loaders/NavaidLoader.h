@@ -19,6 +19,7 @@
 #define SRC_LIBXDATA_LOADERS_NAVAIDLOADER_H_
 
 #include <memory>
+#include <vector>
 #include "src/libxdata/parsers/NavaidParser.h"
 #include "src/libxdata/world/World.h"
 
@@ -28,6 +29,10 @@ class NavaidLoader {
 public:
     NavaidLoader(std::shared_ptr<World> worldPtr);
     void load(const std::string &file);
+
+    // apply() reuses fixes with the same region and ID and attaches localizers to their airports
+    std::vector<NavaidData> parse(const std::string &file) const;
+    void apply(const std::vector<NavaidData> &entries);
 private:
     std::shared_ptr<World> world;
 
@@ -231,7 +231,23 @@ void Airport::addApproach(std::shared_ptr<Approach> approach) {
     approaches.insert(std::make_pair(approach->getID(), approach));
 }
 
+void Airport::setProcedureLoader(std::shared_ptr<const ProcedureLoader> loader) {
+    procedureLoader = loader;
+}
+
+void Airport::loadProcedures() const {
+    if (!procedureLoader) {
+        return;
+    }
+
+    // concurrent callers wait until the first one has added the procedures
+    std::call_once(proceduresLoaded, [this] () {
+        (*procedureLoader)(std::const_pointer_cast<Airport>(shared_from_this()));
+    });
+}
+
 std::vector<std::shared_ptr<SID>> Airport::getSIDs() const {
+    loadProcedures();
     std::vector<std::shared_ptr<SID>> res;
     for (auto &it: sids) {
         res.push_back(it.second);
@@ -240,6 +256,7 @@ std::vector<std::shared_ptr<SID>> Airport::getSIDs() const {
 }
 
 std::vector<std::shared_ptr<STAR>> Airport::getSTARs() const {
+    loadProcedures();
     std::vector<std::shared_ptr<STAR>> res;
     for (auto &it: stars) {
         res.push_back(it.second);
@@ -248,6 +265,7 @@ std::vector<std::shared_ptr<STAR>> Airport::getSTARs() const {
 }
 
 std::vector<std::shared_ptr<Approach>> Airport::getApproaches() const {
+    loadProcedures();
     std::vector<std::shared_ptr<Approach>> res;
     for (auto &it: approaches) {
         res.push_back(it.second);
@@ -24,6 +24,7 @@
 #include <vector>
 #include <set>
 #include <functional>
+#include <mutex>
 #include "src/libxdata/world/models/Region.h"
 #include "src/libxdata/world/models/Frequency.h"
 #include "src/libxdata/world/models/Location.h"
@@ -38,8 +39,11 @@ namespace xdata {
 
 class Fix;
 
-class Airport: public NavNode {
+class Airport: public NavNode, public std::enable_shared_from_this<Airport> {
 public:
+    // Adds the procedures of an airport, shared by all airports
+    using ProcedureLoader = std::function<void(std::shared_ptr<Airport>)>;
+
     enum class ATCFrequency {
         RECORDED,
         UNICOM,
@@ -91,6 +95,10 @@ public:
     void addSTAR(std::shared_ptr<STAR> star);
     void addApproach(std::shared_ptr<Approach> approach);
 
+    // The procedures are only loaded on first access, or when calling loadProcedures
+    void setProcedureLoader(std::shared_ptr<const ProcedureLoader> loader);
+    void loadProcedures() const;
+
     std::vector<std::shared_ptr<SID>> getSIDs() const;
     std::vector<std::shared_ptr<STAR>> getSTARs() const;
     std::vector<std::shared_ptr<Approach>> getApproaches() const;
@@ -119,6 +127,8 @@ private:
     std::map<std::string, std::shared_ptr<SID>> sids;
     std::map<std::string, std::shared_ptr<STAR>> stars;
     std::map<std::string, std::shared_ptr<Approach>> approaches;
+    std::shared_ptr<const ProcedureLoader> procedureLoader;
+    mutable std::once_flag proceduresLoaded;
 
     std::string metarTimestamp, metarString;
 
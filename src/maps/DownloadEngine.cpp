@@ -0,0 +1,351 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <stdexcept>
+#include <cstring>
+#include <future>
+#include <algorithm>
+#include <iterator>
+#include "DownloadEngine.h"
+#include "src/platform/CrashHandler.h"
+#include "src/Logger.h"
+
+namespace maps {
+
+std::shared_ptr<DownloadEngine> DownloadEngine::getSharedEngine() {
+    static std::mutex sharedMutex;
+    static std::weak_ptr<DownloadEngine> sharedEngine;
+
+    // lives as long as any source uses it
+    std::lock_guard<std::mutex> lock(sharedMutex);
+    auto engine = sharedEngine.lock();
+    if (!engine) {
+        engine = std::make_shared<DownloadEngine>();
+        sharedEngine = engine;
+    }
+    return engine;
+}
+
+DownloadEngine::DownloadEngine() {
+    multi = curl_multi_init();
+    if (!multi) {
+        throw std::runtime_error("Couldn't initialize curl");
+    }
+
+    curl_version_info_data *info = curl_version_info(CURLVERSION_NOW);
+    useHTTP2 = info && (info->features & CURL_VERSION_HTTP2);
+    if (useHTTP2) {
+        curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    }
+    curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, MAX_CACHED_CONNECTIONS);
+
+    engineThread = std::thread(&DownloadEngine::run, this);
+}
+
+void DownloadEngine::setMaxHostConnections(long count) {
+    std::lock_guard<std::mutex> lock(engineMutex);
+    maxHostConnections = count;
+    settingsChanged = true;
+}
+
+void DownloadEngine::submit(const Request &request, std::atomic_bool &cancel, DoneCallback onDone) {
+    if (cancel) {
+        std::vector<Waiter> waiters { Waiter{&cancel, onDone} };
+        std::vector<uint8_t> noData;
+        notify(waiters, noData, std::make_exception_ptr(std::out_of_range("Cancelled")));
+        return;
+    }
+
+    std::string key = request.url + "\n" + request.cookies;
+
+    std::lock_guard<std::mutex> lock(engineMutex);
+    auto it = transfers.find(key);
+    if (it != transfers.end()) {
+        // same tile requested again while the first request is still running
+        it->second->waiters.push_back(Waiter{&cancel, onDone});
+        return;
+    }
+
+    if (!request.hideURL) {
+        logger::verbose("Downloading '%s'", request.url.c_str());
+    } else {
+        logger::verbose("Downloading...");
+    }
+
+    auto transfer = std::make_shared<Transfer>();
+    transfer->key = key;
+    transfer->request = request;
+    transfer->waiters.push_back(Waiter{&cancel, onDone});
+    transfers[key] = transfer;
+    newTransfers.push_back(transfer);
+    wakeUp();
+}
+
+std::vector<uint8_t> DownloadEngine::download(const Request &request, std::atomic_bool &cancel) {
+    auto promise = std::make_shared<std::promise<std::vector<uint8_t>>>();
+    auto result = promise->get_future();
+
+    submit(request, cancel, [promise] (std::vector<uint8_t> data, std::exception_ptr error) {
+        if (error) {
+            promise->set_exception(error);
+        } else {
+            promise->set_value(std::move(data));
+        }
+    });
+
+    return result.get();
+}
+
+void DownloadEngine::wakeUp() {
+    // gets called with locked mutex
+    engineCondition.notify_one();
+#if LIBCURL_VERSION_NUM >= 0x074400
+    curl_multi_wakeup(multi);
+#endif
+}
+
+void DownloadEngine::run() {
+    crash::ThreadCookie crashCookie;
+
+    while (keepAlive) {
+        std::vector<std::shared_ptr<Transfer>> toStart;
+        {
+            std::lock_guard<std::mutex> lock(engineMutex);
+            toStart.swap(newTransfers);
+            if (settingsChanged) {
+                curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, maxHostConnections);
+                settingsChanged = false;
+            }
+        }
+
+        for (auto &transfer: toStart) {
+            startTransfer(transfer);
+        }
+
+        dropCancelledWaiters();
+
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        CURLMsg *msg;
+        int msgsLeft = 0;
+        while ((msg = curl_multi_info_read(multi, &msgsLeft)) != nullptr) {
+            if (msg->msg == CURLMSG_DONE) {
+                finishTransfer(msg->easy_handle, msg->data.result);
+            }
+        }
+
+        waitForActivity();
+    }
+
+    // fail everything that is still pending
+    std::vector<Waiter> waiters;
+    {
+        std::lock_guard<std::mutex> lock(engineMutex);
+        for (auto &it: transfers) {
+            removeTransfer(*it.second);
+            for (auto &waiter: it.second->waiters) {
+                waiters.push_back(std::move(waiter));
+            }
+        }
+        transfers.clear();
+        newTransfers.clear();
+    }
+    std::vector<uint8_t> noData;
+    notify(waiters, noData, std::make_exception_ptr(std::out_of_range("Cancelled")));
+}
+
+void DownloadEngine::waitForActivity() {
+    {
+        // sleep without spinning if there's nothing to transfer
+        std::unique_lock<std::mutex> lock(engineMutex);
+        engineCondition.wait_for(lock, std::chrono::milliseconds(POLL_TIMEOUT_MS), [this] () {
+            return !keepAlive || !transfers.empty();
+        });
+        if (!keepAlive || !newTransfers.empty() || transfers.empty()) {
+            return;
+        }
+    }
+
+#if LIBCURL_VERSION_NUM >= 0x074400
+    // returns early for socket activity or curl_multi_wakeup
+    curl_multi_poll(multi, nullptr, 0, POLL_TIMEOUT_MS, nullptr);
+#else
+    // can't be woken up, so keep the delay for new requests short
+    curl_multi_wait(multi, nullptr, 0, 10, nullptr);
+#endif
+}
+
+void DownloadEngine::startTransfer(std::shared_ptr<Transfer> transfer) {
+    // gets called from the engine thread only
+    CURL *curl = curl_easy_init();
+    if (!curl) {
+        std::vector<Waiter> waiters;
+        {
+            std::lock_guard<std::mutex> lock(engineMutex);
+            transfers.erase(transfer->key);
+            waiters = std::move(transfer->waiters);
+        }
+        notify(waiters, transfer->data, std::make_exception_ptr(std::runtime_error("Couldn't initialize curl")));
+        return;
+    }
+
+    const Request &request = transfer->request;
+    curl_easy_setopt(curl, CURLOPT_URL, request.url.c_str());
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "AviTab " AVITAB_VERSION_STR);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    if (!request.cookies.empty()) {
+        curl_easy_setopt(curl, CURLOPT_COOKIE, request.cookies.c_str());
+    }
+    if (useHTTP2) {
+        // wait for a connection that can multiplex instead of opening a new one
+        curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, (long) CURL_HTTP_VERSION_2TLS);
+        curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+    }
+
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *) &transfer->data);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, onData);
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, (void *) transfer.get());
+
+    std::lock_guard<std::mutex> lock(engineMutex);
+    transfer->curl = curl;
+    curl_multi_add_handle(multi, curl);
+}
+
+void DownloadEngine::finishTransfer(CURL *curl, CURLcode code) {
+    // gets called from the engine thread only
+    Transfer *transferPtr = nullptr;
+    curl_easy_getinfo(curl, CURLINFO_PRIVATE, (char **) &transferPtr);
+    if (!transferPtr) {
+        return;
+    }
+
+    std::exception_ptr error;
+    if (code != CURLE_OK) {
+        error = std::make_exception_ptr(std::runtime_error(std::string("Download error: ") + curl_easy_strerror(code)));
+    } else {
+        long httpStatus = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpStatus);
+        if (httpStatus != 200) {
+            error = std::make_exception_ptr(std::runtime_error(std::string("Download error - HTTP status " + std::to_string(httpStatus))));
+        }
+    }
+
+    std::shared_ptr<Transfer> transfer;
+    std::vector<Waiter> waiters;
+    {
+        std::lock_guard<std::mutex> lock(engineMutex);
+        auto it = transfers.find(transferPtr->key);
+        if (it == transfers.end() || it->second.get() != transferPtr) {
+            return;
+        }
+        transfer = it->second;
+        transfers.erase(it);
+        removeTransfer(*transfer);
+        waiters = std::move(transfer->waiters);
+    }
+
+    notify(waiters, transfer->data, error);
+}
+
+void DownloadEngine::dropCancelledWaiters() {
+    // gets called from the engine thread only
+    std::vector<Waiter> cancelled;
+    {
+        std::lock_guard<std::mutex> lock(engineMutex);
+        for (auto it = transfers.begin(); it != transfers.end(); ) {
+            Transfer &transfer = *it->second;
+            if (!transfer.curl) {
+                // not started yet, checked after it was started
+                ++it;
+                continue;
+            }
+
+            auto &waiters = transfer.waiters;
+            auto firstCancelled = std::stable_partition(waiters.begin(), waiters.end(), [] (const Waiter &w) {
+                return !*w.cancel;
+            });
+            std::move(firstCancelled, waiters.end(), std::back_inserter(cancelled));
+            waiters.erase(firstCancelled, waiters.end());
+
+            if (waiters.empty()) {
+                // nobody wants the result anymore
+                removeTransfer(transfer);
+                it = transfers.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    std::vector<uint8_t> noData;
+    notify(cancelled, noData, std::make_exception_ptr(std::out_of_range("Cancelled")));
+}
+
+void DownloadEngine::removeTransfer(Transfer &transfer) {
+    // gets called with locked mutex from the engine thread
+    if (transfer.curl) {
+        curl_multi_remove_handle(multi, transfer.curl);
+        curl_easy_cleanup(transfer.curl);
+        transfer.curl = nullptr;
+    }
+}
+
+void DownloadEngine::notify(std::vector<Waiter> &waiters, std::vector<uint8_t> &data, std::exception_ptr error) {
+    // gets called unlocked, the last waiter gets the data without a copy
+    for (size_t i = 0; i < waiters.size(); i++) {
+        std::vector<uint8_t> result;
+        if (!error) {
+            result = (i + 1 < waiters.size()) ? data : std::move(data);
+        }
+
+        try {
+            waiters[i].onDone(std::move(result), error);
+        } catch (const std::exception &e) {
+            logger::warn("Download callback failed: %s", e.what());
+        }
+    }
+}
+
+size_t DownloadEngine::onData(void* buffer, size_t size, size_t nmemb, void* vecPtr) {
+    std::vector<uint8_t> *vec = reinterpret_cast<std::vector<uint8_t> *>(vecPtr);
+    if (!vec) {
+        return 0;
+    }
+    size_t pos = vec->size();
+    vec->resize(pos + size * nmemb);
+    std::memcpy(vec->data() + pos, buffer, size * nmemb);
+    return size * nmemb;
+}
+
+DownloadEngine::~DownloadEngine() {
+    {
+        std::lock_guard<std::mutex> lock(engineMutex);
+        keepAlive = false;
+        wakeUp();
+    }
+
+    if (engineThread.joinable()) {
+        engineThread.join();
+    }
+
+    curl_multi_cleanup(multi);
+}
+
+} /* namespace maps */
@@ -0,0 +1,110 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SRC_MAPS_DOWNLOADENGINE_H_
+#define SRC_MAPS_DOWNLOADENGINE_H_
+
+#include <map>
+#include <vector>
+#include <cstdint>
+#include <string>
+#include <memory>
+#include <functional>
+#include <exception>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <curl/curl.h>
+
+namespace maps {
+
+/*
+ * Runs all transfers on one curl multi handle in its own thread so that
+ * connections are kept alive and reused between requests, multiplexed
+ * with HTTP/2 if libcurl supports it and limited per host.
+ */
+class DownloadEngine {
+public:
+    using DoneCallback = std::function<void(std::vector<uint8_t> data, std::exception_ptr error)>;
+
+    struct Request {
+        std::string url;
+        std::string cookies; // as for the Cookie header
+        bool hideURL = false;
+    };
+
+    // All sources share one engine so that they also share the connections
+    static std::shared_ptr<DownloadEngine> getSharedEngine();
+
+    DownloadEngine();
+    void setMaxHostConnections(long count);
+
+    // Returns right away, onDone gets called from the engine thread. A cancelled request
+    // fails with std::out_of_range. Requests for the same URL share one transfer.
+    // cancel must stay valid until onDone was called.
+    void submit(const Request &request, std::atomic_bool &cancel, DoneCallback onDone);
+
+    // Blocks until the download is done, throws like submit would fail
+    std::vector<uint8_t> download(const Request &request, std::atomic_bool &cancel);
+
+    ~DownloadEngine();
+private:
+    static constexpr const long DEFAULT_MAX_HOST_CONNECTIONS = 4;
+    static constexpr const long MAX_CACHED_CONNECTIONS = 16;
+    static constexpr const int POLL_TIMEOUT_MS = 100;
+
+    struct Waiter {
+        std::atomic_bool *cancel;
+        DoneCallback onDone;
+    };
+
+    struct Transfer {
+        std::string key;
+        Request request;
+        CURL *curl = nullptr;
+        std::vector<uint8_t> data;
+        std::vector<Waiter> waiters;
+    };
+
+    CURLM *multi = nullptr;
+    bool useHTTP2 = false;
+    std::thread engineThread;
+    std::atomic_bool keepAlive { true };
+
+    std::mutex engineMutex;
+    std::condition_variable engineCondition;
+    std::map<std::string, std::shared_ptr<Transfer>> transfers; // by URL and cookies, queued or running
+    std::vector<std::shared_ptr<Transfer>> newTransfers;
+    long maxHostConnections = DEFAULT_MAX_HOST_CONNECTIONS;
+    bool settingsChanged = true;
+
+    void run();
+    void waitForActivity();
+    void startTransfer(std::shared_ptr<Transfer> transfer);
+    void finishTransfer(CURL *curl, CURLcode code);
+    void dropCancelledWaiters();
+    void removeTransfer(Transfer &transfer);
+    void wakeUp();
+
+    static void notify(std::vector<Waiter> &waiters, std::vector<uint8_t> &data, std::exception_ptr error);
+    static size_t onData(void *buffer, size_t size, size_t nmemb, void *vecPtr);
+};
+
+} /* namespace maps */
+
+#endif /* SRC_MAPS_DOWNLOADENGINE_H_ */
@@ -22,23 +22,28 @@
 #include <vector>
 #include <cstdint>
 #include <string>
-#include <curl/curl.h>
+#include <atomic>
+#include <memory>
+#include "DownloadEngine.h"
 
 namespace maps {
 
+// Thread-safe once set up, all downloaders share the connections of one DownloadEngine
 class Downloader {
 public:
     Downloader();
     void setHideURLs(bool hide);
     void setCookies(const std::map<std::string, std::string> &cks);
-    std::vector<uint8_t> download(const std::string &url, bool &cancel);
-    ~Downloader();
+    std::vector<uint8_t> download(const std::string &url, std::atomic_bool &cancel);
+
+    // Returns right away, onDone gets called from the engine thread
+    void downloadAsync(const std::string &url, std::atomic_bool &cancel, DownloadEngine::DoneCallback onDone);
 private:
-    CURL *curl = nullptr;
+    std::shared_ptr<DownloadEngine> engine;
     bool hideURLs = false;
+    std::string cookies;
 
-    static size_t onData(void *buffer, size_t size, size_t nmemb, void *resPtr);
-    static int onProgress(void *client, curl_off_t dlTotal, curl_off_t dlNow, curl_off_t ulTotal, curl_off_t ulNow);
+    DownloadEngine::Request createRequest(const std::string &url) const;
 };
 
 } /* namespace maps */
@@ -38,6 +38,18 @@ struct OverlayConfig {
     bool drawPOIs = false;
     bool drawVRPs = false;
     bool drawMarkers = false;
+
+    bool hasNavDataOverlays() const {
+        return drawAirports || drawAirstrips || drawHeliportsSeaports || drawVORs || drawNDBs ||
+               drawILSs || drawWaypoints || drawPOIs || drawVRPs || drawMarkers;
+    }
+
+    bool sameNavDataOverlays(const OverlayConfig &other) const {
+        return drawAirports == other.drawAirports && drawAirstrips == other.drawAirstrips &&
+               drawHeliportsSeaports == other.drawHeliportsSeaports && drawVORs == other.drawVORs &&
+               drawNDBs == other.drawNDBs && drawILSs == other.drawILSs && drawWaypoints == other.drawWaypoints &&
+               drawPOIs == other.drawPOIs && drawVRPs == other.drawVRPs && drawMarkers == other.drawMarkers;
+    }
 };
 
 } /* namespace maps */
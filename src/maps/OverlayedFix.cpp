@@ -42,6 +42,17 @@ bool OverlayedFix::isDMEOnly(const xdata::Fix &fix) {
     return fix.getDME() && !fix.getVOR() && !fix.getILSLocalizer();
 }
 
+int OverlayedFix::getVisibleWorldLayers(OverlayHelper helper) {
+    int layers = 0;
+    if (helper->getMapWidthNM() <= SHOW_USERFIXES_AT_MAPWIDTHNM) {
+        layers |= xdata::World::LAYER_USER_FIXES;
+    }
+    if (helper->getMapWidthNM() <= SHOW_NAVAIDS_AT_MAPWIDTHNM) {
+        layers |= xdata::World::LAYER_FIXES;
+    }
+    return layers;
+}
+
 std::shared_ptr<OverlayedFix> OverlayedFix::getInstanceIfVisible(OverlayHelper helper, const xdata::Fix &fix) {
     int show_at_mapwidth = fix.getUserFix() ? SHOW_USERFIXES_AT_MAPWIDTHNM : SHOW_NAVAIDS_AT_MAPWIDTHNM;
     if (helper->getMapWidthNM() > show_at_mapwidth) {
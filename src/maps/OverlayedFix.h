@@ -21,6 +21,7 @@
 #include "OverlayedNode.h"
 #include "src/libxdata/world/models/navaids/Fix.h"
 #include "src/libxdata/world/models/navaids/Morse.h"
+#include "src/libxdata/world/World.h"
 
 namespace maps {
 
@@ -29,6 +30,9 @@ class OverlayedFix : public OverlayedNode {
 public:
     static std::shared_ptr<OverlayedFix> getInstanceIfVisible(OverlayHelper helper, const xdata::Fix &fix);
 
+    // The world layers that can contain visible fixes at the current map width
+    static int getVisibleWorldLayers(OverlayHelper helper);
+
     virtual void drawGraphics() = 0;
     virtual void drawText(bool detailed) = 0;
 
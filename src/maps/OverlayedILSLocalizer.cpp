@@ -102,9 +102,9 @@ void OverlayedILSLocalizer::getTailCoords(OverlayHelper helper, const xdata::Fix
     }
     double ilsHeading = std::fmod(ils->getRunwayHeading() + 180.0, 360);
     double rangePixels = 0.0;
-    if (helper->getMapWidthNM() != 0) {
-        auto mapImage = helper->getMapImage();
-        rangePixels = (ils->getRange() * mapImage->getWidth()) / helper->getMapWidthNM();
+    if (helper->getNMPerPixel() != 0) {
+        // not from the image width, the overlays can be drawn onto a layer that is larger than the map
+        rangePixels = ils->getRange() / helper->getNMPerPixel();
     }
     double dcx, dcy, dlx, dly, drx, dry;
     const double OUTER_ANGLE = 2.5;
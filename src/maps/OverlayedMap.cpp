@@ -20,6 +20,7 @@
 #include <cmath>
 #include "OverlayedMap.h"
 #include "OverlayedNode.h"
+#include "OverlayedFix.h"
 #include "src/Logger.h"
 
 namespace maps {
@@ -109,6 +110,12 @@ void OverlayedMap::setPlaneLocations(std::vector<avitab::Location> &locs) {
     }
     planeLocations = locs;
 
+    if (!planeLocations.empty()) {
+        int zoomLevel = stitcher->getZoomLevel();
+        auto planeXY = tileSource->worldToXY(planeLocations[0].longitude, planeLocations[0].latitude, zoomLevel);
+        stitcher->setPriorityPoint(planeXY.x, planeXY.y);
+    }
+
     if (movement) {
         stitcher->updateImage();
     }
@@ -151,11 +158,15 @@ void OverlayedMap::doWork() {
 }
 
 void OverlayedMap::drawOverlays() {
+    // the stitcher uses a different image depending on the rotation
+    mapImage = stitcher->getPreRotatedImage();
     if ((mapImage->getWidth() == 0) || (mapImage->getHeight() == 0)) {
         return;
     }
+    setVisibleArea(0, 0, mapImage->getWidth(), mapImage->getHeight());
+
     if (tileSource->supportsWorldCoords()) {
-        drawDataOverlays();
+        drawStaticOverlays();
         drawOtherAircraftOverlay();
         drawAircraftOverlay();
     }
@@ -236,16 +247,30 @@ void OverlayedMap::drawCalibrationOverlay() {
     mapImage->drawLine(centerX, centerY + r / 2, centerX, centerY - r / 2, color);
 }
 
-void OverlayedMap::drawDataOverlays() {
-    if (!navWorld) {
+void OverlayedMap::drawStaticOverlays() {
+    if (!navWorld || !overlayConfig->hasNavDataOverlays()) {
+        navLayerValid = false;
         return;
     }
-    if (!overlayConfig->drawAirports && !overlayConfig->drawAirstrips && !overlayConfig->drawHeliportsSeaports &&
-        !overlayConfig->drawVORs && !overlayConfig->drawNDBs && !overlayConfig->drawILSs && !overlayConfig->drawWaypoints &&
-        !overlayConfig->drawPOIs && !overlayConfig->drawVRPs && !overlayConfig->drawMarkers) {
+
+    if (!measureMap()) {
         return;
     }
 
+    auto key = getNavLayerKey();
+    int offsetX = 0, offsetY = 0;
+    if (!navLayerValid || !(key == navLayerKey) || !getNavLayerOffset(offsetX, offsetY)) {
+        drawNavLayer();
+        navLayerKey = key;
+        navLayerValid = true;
+        getNavLayerOffset(offsetX, offsetY);
+    }
+
+    mapImage->blendImage0(*navLayer, offsetX, offsetY);
+    drawScale(nmPerPixel);
+}
+
+bool OverlayedMap::measureMap() {
     double leftLon, rightLon;
     double upLat, bottomLat;
     pixelToPosition(0, 0, upLat, leftLon);
@@ -259,31 +284,138 @@ void OverlayedMap::drawDataOverlays() {
     // Don't overlay anything if zoomed out to world view. Too much to draw.
     // And haversine formula used by distanceTo misbehaves in world views.
     if ((deltaLon > 180) || (deltaLon < 0)) {
-        return;
+        return false;
     }
 
     // Calculate scaling from a hybrid of horizontal and vertical axes
     double diagonalPixels = sqrt(pow(mapImage->getWidth(), 2) + pow(mapImage->getHeight(), 2));
     double metresPerPixel = upLeft.distanceTo(downRight) / diagonalPixels;
-    double nmPerPixel = metresPerPixel / 1852;
+    nmPerPixel = metresPerPixel / 1852;
     mapWidthNM = nmPerPixel * mapImage->getWidth();
 
-    // Gather list of visible OverlayedNodes, instancing those that are visible
+    LOG_INFO(dbg, "zoom = %2d, deltaLon = %7.3f, %5.4f nm/pix, mapWidth = %6.1f nm",
+        stitcher->getZoomLevel(), deltaLon, nmPerPixel, mapWidthNM);
+    return true;
+}
+
+void OverlayedMap::drawNavLayer() {
+    int mapWidth = mapImage->getWidth();
+    int mapHeight = mapImage->getHeight();
+    if (!navLayer) {
+        navLayer = std::make_shared<img::Image>();
+    }
+    navLayer->resize(mapWidth + 2 * NAV_LAYER_MARGIN_PIXELS, mapHeight + 2 * NAV_LAYER_MARGIN_PIXELS, img::COLOR_TRANSPARENT);
+    navLayerCenter = stitcher->getCenter();
+
+    // the overlays draw onto getMapImage() and position themselves with positionToPixel,
+    // so both refer to the layer while it is drawn
+    auto map = mapImage;
+    mapImage = navLayer;
+    drawingNavLayer = true;
+    try {
+        drawDataOverlays(NAV_LAYER_MARGIN_PIXELS, NAV_LAYER_MARGIN_PIXELS, mapWidth, mapHeight);
+    } catch (...) {
+        drawingNavLayer = false;
+        mapImage = map;
+        throw;
+    }
+    drawingNavLayer = false;
+    mapImage = map;
+    setVisibleArea(0, 0, mapWidth, mapHeight);
+}
+
+bool OverlayedMap::getNavLayerOffset(int &x, int &y) const {
+    // where the layer's top left corner is on the map, false if it doesn't cover the whole map
+    auto dim = tileSource->getTileDimensions(stitcher->getZoomLevel());
+    auto center = stitcher->getCenter();
+    x = mapImage->getWidth() / 2 - navLayer->getWidth() / 2 + std::lround((navLayerCenter.x - center.x) * dim.x);
+    y = mapImage->getHeight() / 2 - navLayer->getHeight() / 2 + std::lround((navLayerCenter.y - center.y) * dim.y);
+
+    return x <= 0 && y <= 0 &&
+           x + navLayer->getWidth() >= mapImage->getWidth() &&
+           y + navLayer->getHeight() >= mapImage->getHeight();
+}
+
+OverlayedMap::NavLayerKey OverlayedMap::getNavLayerKey() const {
+    NavLayerKey key;
+    key.mapWidth = mapImage->getWidth();
+    key.mapHeight = mapImage->getHeight();
+    key.zoom = stitcher->getZoomLevel();
+    key.page = stitcher->getCurrentPage();
+    key.world = navWorld.get();
+    key.worldIndexVersion = navWorld ? navWorld->getIndexVersion() : 0;
+    key.config = *overlayConfig;
+    return key;
+}
+
+bool OverlayedMap::NavLayerKey::operator==(const NavLayerKey &other) const {
+    return mapWidth == other.mapWidth && mapHeight == other.mapHeight &&
+           zoom == other.zoom && page == other.page &&
+           world == other.world && worldIndexVersion == other.worldIndexVersion &&
+           config.sameNavDataOverlays(other.config);
+}
+
+void OverlayedMap::drawDataOverlays(int mapX, int mapY, int mapWidth, int mapHeight) {
+    // Gets called while drawing the nav layer, the map is the given part of it
+
+    // Only search the area that can contain visible nodes: symbols and text
+    // reach beyond their node and ILS tails reach up to their range
+    double searchUpLat, searchLeftLon, searchDownLat, searchRightLon;
+    pixelToPosition(-NODE_SEARCH_MARGIN_PIXELS, -NODE_SEARCH_MARGIN_PIXELS, searchUpLat, searchLeftLon);
+    pixelToPosition(mapImage->getWidth() - 1 + NODE_SEARCH_MARGIN_PIXELS, mapImage->getHeight() - 1 + NODE_SEARCH_MARGIN_PIXELS,
+                    searchDownLat, searchRightLon);
+    if (overlayConfig->drawILSs) {
+        double latMargin = ILS_SEARCH_MARGIN_NM / 60.0;
+        double lonMargin = latMargin / std::max(0.01, std::cos(std::max(std::abs(searchUpLat), std::abs(searchDownLat)) * M_PI / 180.0));
+        searchUpLat += latMargin;
+        searchDownLat -= latMargin;
+        searchLeftLon -= lonMargin;
+        searchRightLon += lonMargin;
+    }
+    xdata::Location searchUpLeft { searchUpLat, searchLeftLon };
+    xdata::Location searchDownRight { searchDownLat, searchRightLon };
+
+    std::vector<const xdata::NavNode *> nodes;
+    int layers = xdata::World::LAYER_AIRPORTS | OverlayedFix::getVisibleWorldLayers(shared_from_this());
+    navWorld->visitNodes(searchUpLeft, searchDownRight, [&nodes] (const xdata::NavNode &node) {
+        nodes.push_back(&node);
+    }, layers);
+
+    // Project all candidates in one go so the visibility checks below hit the cache
+    projectNodes(nodes);
+
+    // Gather list of visible OverlayedNodes, instancing those that are visible anywhere on the layer
     std::vector<std::shared_ptr<OverlayedNode>> overlayedAerodromes;
     std::vector<std::shared_ptr<OverlayedNode>> overlayedFixes;
-    navWorld->visitNodes(upLeft, downRight, [this, &overlayedAerodromes, &overlayedFixes] (const xdata::NavNode &node) {
-        auto overlayedNode = OverlayedNode::getInstanceIfVisible(shared_from_this(), node);
+    std::vector<const xdata::NavNode *> visibleNodes;
+    for (auto node: nodes) {
+        auto overlayedNode = OverlayedNode::getInstanceIfVisible(shared_from_this(), *node);
         if (overlayedNode) {
-            if (dynamic_cast<const xdata::Airport *>(&node)) {
+            if (dynamic_cast<const xdata::Airport *>(node)) {
                 overlayedAerodromes.push_back(overlayedNode);
-            } else if (dynamic_cast<const xdata::Fix *>(&node)) {
+                visibleNodes.push_back(node);
+            } else if (dynamic_cast<const xdata::Fix *>(node)) {
                 overlayedFixes.push_back(overlayedNode);
+                visibleNodes.push_back(node);
             }
         }
-    });
+    }
 
-    numAerodromesVisible = overlayedAerodromes.size();
-    LOG_INFO(dbg, "%d aerodromes, %d fixes visible", numAerodromesVisible, overlayedFixes.size());
+    // The level of detail depends on what can be seen on the map, not on the whole layer
+    setVisibleArea(mapX, mapY, mapX + mapWidth, mapY + mapHeight);
+    int numNodesVisible = 0;
+    int numAerodromesOnMap = 0;
+    for (auto node: visibleNodes) {
+        if (OverlayedNode::getInstanceIfVisible(shared_from_this(), *node)) {
+            numNodesVisible++;
+            if (dynamic_cast<const xdata::Airport *>(node)) {
+                numAerodromesOnMap++;
+            }
+        }
+    }
+    numAerodromesVisible = numAerodromesOnMap;
+    setVisibleArea(0, 0, mapImage->getWidth(), mapImage->getHeight());
+    LOG_INFO(dbg, "%d aerodromes, %d fixes visible", numAerodromesVisible, numNodesVisible - numAerodromesVisible);
 
     // Render the list of visible OverlayedNodes:
     // Fix graphics, aerodrome graphics, then fix text and aerodrome text.
@@ -295,7 +427,6 @@ void OverlayedMap::drawDataOverlays() {
         overlayedNode->drawGraphics();
     }
 
-    int numNodesVisible = overlayedAerodromes.size() + overlayedFixes.size();
     if (numNodesVisible < MAX_VISIBLE_OBJECTS_TO_SHOW_TEXT) {
         bool detailedText = numNodesVisible < MAX_VISIBLE_OBJECTS_TO_SHOW_DETAILED_TEXT;
         for (auto overlayedNode : overlayedFixes) {
@@ -305,17 +436,16 @@ void OverlayedMap::drawDataOverlays() {
             overlayedNode->drawText(detailedText);
         }
     }
-
-    LOG_INFO(dbg, "zoom = %2d, deltaLon = %7.3f, %5.4f nm/pix, mapWidth = %6.1f nm",
-        stitcher->getZoomLevel(), deltaLon, nmPerPixel, mapWidthNM);
-
-    drawScale(nmPerPixel);
 }
 
 double OverlayedMap::getMapWidthNM() const {
     return mapWidthNM;
 }
 
+double OverlayedMap::getNMPerPixel() const {
+    return nmPerPixel;
+}
+
 int OverlayedMap::getNumAerodromesVisible() const {
     return numAerodromesVisible;
 }
@@ -359,20 +489,85 @@ void OverlayedMap::positionToPixel(double lat, double lon, int& px, int& py, int
     auto dim = tileSource->getTileDimensions(zoomLevel);
 
     // Center tile num
-    auto centerXY = stitcher->getCenter();
+    auto centerXY = getDrawCenter();
 
     // Target tile num
-    auto tileXY = tileSource->worldToXY(lon, lat, zoomLevel);
+    auto tileXY = worldToTile(lat, lon, zoomLevel);
 
     px = mapImage->getWidth() / 2 + (tileXY.x - centerXY.x) * dim.x;
     py = mapImage->getHeight() / 2 + (tileXY.y - centerXY.y) * dim.y;
 }
 
+size_t OverlayedMap::LocationHash::operator()(const std::pair<double, double> &latLon) const {
+    std::hash<double> hasher;
+    size_t h = hasher(latLon.first);
+    return h ^ (hasher(latLon.second) + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2));
+}
+
+img::Point<double> OverlayedMap::worldToTile(double lat, double lon, int zoomLevel) const {
+    if (zoomLevel != stitcher->getZoomLevel()) {
+        // e.g. runway lengths measured at the maximum zoom, not worth caching
+        return tileSource->worldToXY(lon, lat, zoomLevel);
+    }
+
+    syncProjectionCache(zoomLevel);
+
+    // only nav nodes are cached by projectNodes, aircraft and other one-off
+    // positions would just push them out of the cache
+    auto it = projectionCache.find(std::make_pair(lat, lon));
+    if (it != projectionCache.end()) {
+        return it->second;
+    }
+
+    return tileSource->worldToXY(lon, lat, zoomLevel);
+}
+
+void OverlayedMap::projectNodes(const std::vector<const xdata::NavNode *> &nodes) const {
+    int zoomLevel = stitcher->getZoomLevel();
+    syncProjectionCache(zoomLevel);
+
+    std::vector<double> lats, lons;
+    for (auto node: nodes) {
+        auto &loc = node->getLocation();
+        if (projectionCache.find(std::make_pair(loc.latitude, loc.longitude)) == projectionCache.end()) {
+            lats.push_back(loc.latitude);
+            lons.push_back(loc.longitude);
+        }
+    }
+
+    if (lats.empty()) {
+        return;
+    }
+
+    std::vector<double> xs(lats.size()), ys(lats.size());
+    tileSource->worldToXYBatch(lons.data(), lats.data(), xs.data(), ys.data(), lats.size(), zoomLevel);
+
+    if (projectionCache.size() + lats.size() > MAX_PROJECTION_CACHE_ENTRIES) {
+        projectionCache.clear();
+    }
+    for (size_t i = 0; i < lats.size(); i++) {
+        projectionCache.emplace(std::make_pair(lats[i], lons[i]), img::Point<double>{xs[i], ys[i]});
+    }
+}
+
+void OverlayedMap::syncProjectionCache(int zoomLevel) const {
+    int page = stitcher->getCurrentPage();
+    if (zoomLevel != projectionZoom || page != projectionPage) {
+        projectionCache.clear();
+        projectionZoom = zoomLevel;
+        projectionPage = page;
+    }
+}
+
+void OverlayedMap::invalidateProjectionCache() {
+    projectionCache.clear();
+}
+
 void OverlayedMap::pixelToPosition(int px, int py, double& lat, double& lon) const {
     int zoomLevel = stitcher->getZoomLevel();
     auto dim = tileSource->getTileDimensions(zoomLevel);
 
-    auto centerXY = stitcher->getCenter();
+    auto centerXY = getDrawCenter();
 
     double x = centerXY.x + (px - mapImage->getWidth() / 2.0) / dim.x;
     double y = centerXY.y + (py - mapImage->getHeight() / 2.0) / dim.y;
@@ -418,13 +613,25 @@ bool OverlayedMap::isLocVisibleWithMargin(const xdata::Location &loc, int margin
 }
 
 bool OverlayedMap::isVisibleWithMargin(int x, int y, int marginPixels) const {
-    return  (x > -marginPixels) && (x < mapImage->getWidth() + marginPixels) &&
-            (y > -marginPixels) && (y < mapImage->getHeight() + marginPixels);
+    return  (x > visibleLeft - marginPixels) && (x < visibleRight + marginPixels) &&
+            (y > visibleTop - marginPixels) && (y < visibleBottom + marginPixels);
 }
 
 bool OverlayedMap::isAreaVisible(int xmin, int ymin, int xmax, int ymax) const {
-    return (xmax > 0) && (xmin < mapImage->getWidth()) &&
-           (ymax > 0) && (ymin < mapImage->getHeight());
+    return (xmax > visibleLeft) && (xmin < visibleRight) &&
+           (ymax > visibleTop) && (ymin < visibleBottom);
+}
+
+void OverlayedMap::setVisibleArea(int left, int top, int right, int bottom) {
+    visibleLeft = left;
+    visibleTop = top;
+    visibleRight = right;
+    visibleBottom = bottom;
+}
+
+img::Point<double> OverlayedMap::getDrawCenter() const {
+    // the center of mapImage in tile coordinates
+    return drawingNavLayer ? navLayerCenter : stitcher->getCenter();
 }
 
 int OverlayedMap::getZoomLevel() const {
@@ -447,6 +654,8 @@ void OverlayedMap::beginCalibration() {
 void OverlayedMap::setCalibrationPoint1(double lat, double lon) {
     auto center = stitcher->getCenter();
     tileSource->attachCalibration1(center.x, center.y, lat, lon, stitcher->getZoomLevel());
+    invalidateProjectionCache();
+    navLayerValid = false;
 
     calibrationStep = 2;
     updateImage();
@@ -455,6 +664,8 @@ void OverlayedMap::setCalibrationPoint1(double lat, double lon) {
 void OverlayedMap::setCalibrationPoint2(double lat, double lon) {
     auto center = stitcher->getCenter();
     tileSource->attachCalibration2(center.x, center.y, lat, lon, stitcher->getZoomLevel());
+    invalidateProjectionCache();
+    navLayerValid = false;
 
     calibrationStep = 0;
     updateImage();
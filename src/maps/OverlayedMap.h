@@ -20,6 +20,8 @@
 
 #include <memory>
 #include <functional>
+#include <unordered_map>
+#include <utility>
 #include "src/libimg/stitcher/Stitcher.h"
 #include "src/libxdata/world/World.h"
 #include "src/libimg/TTFStamper.h"
@@ -63,6 +65,7 @@ public:
     void positionToPixel(double lat, double lon, int &px, int &py) const override;
     void positionToPixel(double lat, double lon, int &px, int &py, int zoomLevel) const override;
     double getMapWidthNM() const override;
+    double getNMPerPixel() const override;
     int getNumAerodromesVisible() const override;
     OverlayConfig &getOverlayConfig() const override;
     bool isLocVisibleWithMargin(const xdata::Location &loc, int margin) const override;
@@ -78,6 +81,7 @@ private:
     std::shared_ptr<img::TileSource> tileSource;
     OverlaysDrawnCallback onOverlaysDrawn;
     double mapWidthNM;
+    double nmPerPixel = 0;
     int numAerodromesVisible;
 
     float sinTable[360];
@@ -98,20 +102,65 @@ private:
     // Tiles
     std::shared_ptr<img::Stitcher> stitcher;
 
+    // The nav data overlays are drawn onto a transparent layer that reaches NAV_LAYER_MARGIN_PIXELS
+    // beyond the map on each side. It is anchored in tile coordinates, so pans, centering on the
+    // aircraft and arriving tiles only change where it is composited onto the map.
+    struct NavLayerKey {
+        int mapWidth, mapHeight;
+        int zoom, page;
+        const xdata::World *world;
+        uint64_t worldIndexVersion;
+        OverlayConfig config;
+
+        bool operator==(const NavLayerKey &other) const;
+    };
+    std::shared_ptr<img::Image> navLayer;
+    NavLayerKey navLayerKey {};
+    bool navLayerValid = false;
+    img::Point<double> navLayerCenter;
+    bool drawingNavLayer = false;
+
+    // The part of mapImage that counts as visible for the overlays
+    int visibleLeft = 0, visibleTop = 0, visibleRight = 0, visibleBottom = 0;
+
+    // Tile coordinates of nav node positions, only valid for projectionZoom and projectionPage.
+    // Only used from the drawing path, so no locking.
+    struct LocationHash {
+        size_t operator()(const std::pair<double, double> &latLon) const;
+    };
+    mutable std::unordered_map<std::pair<double, double>, img::Point<double>, LocationHash> projectionCache;
+    mutable int projectionZoom = 0;
+    mutable int projectionPage = 0;
+
     void drawOverlays();
     void drawAircraftOverlay();
     void drawOtherAircraftOverlay();
-    void drawDataOverlays();
+    void drawStaticOverlays();
+    bool measureMap();
+    void drawNavLayer();
+    bool getNavLayerOffset(int &x, int &y) const;
+    void drawDataOverlays(int mapX, int mapY, int mapWidth, int mapHeight);
+    NavLayerKey getNavLayerKey() const;
+    void setVisibleArea(int left, int top, int right, int bottom);
+    img::Point<double> getDrawCenter() const;
     void drawCalibrationOverlay();
     void drawScale(double nmPerPixel);
 
     void pixelToPosition(int px, int py, double &lat, double &lon) const;
+    img::Point<double> worldToTile(double lat, double lon, int zoomLevel) const;
+    void projectNodes(const std::vector<const xdata::NavNode *> &nodes) const;
+    void syncProjectionCache(int zoomLevel) const;
+    void invalidateProjectionCache();
     float cosDegrees(int angleDegrees) const;
     float sinDegrees(int angleDegrees) const;
     void polarToCartesian(float radius, float angleRadians, double& x, double& y);
 
     static const int MAX_VISIBLE_OBJECTS_TO_SHOW_TEXT = 200;
     static const int MAX_VISIBLE_OBJECTS_TO_SHOW_DETAILED_TEXT = 40;
+    static const int NODE_SEARCH_MARGIN_PIXELS = 100;
+    static const int NAV_LAYER_MARGIN_PIXELS = 256;
+    static constexpr const double ILS_SEARCH_MARGIN_NM = 30;
+    static const size_t MAX_PROJECTION_CACHE_ENTRIES = 100000;
 };
 
 } /* namespace maps */
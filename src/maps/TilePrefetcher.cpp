@@ -0,0 +1,241 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cmath>
+#include <algorithm>
+#include "TilePrefetcher.h"
+#include "src/Logger.h"
+
+namespace maps {
+
+TilePrefetcher::TilePrefetcher(std::shared_ptr<img::Stitcher> stitcher):
+    stitcher(stitcher),
+    tileSource(stitcher->getTileSource())
+{
+}
+
+void TilePrefetcher::setRoute(std::shared_ptr<xdata::Route> newRoute) {
+    if (newRoute == route) {
+        return;
+    }
+
+    route = newRoute;
+    routePoints.clear();
+    if (route) {
+        route->iterateRoute([this] (const std::shared_ptr<xdata::NavEdge> via, const std::shared_ptr<xdata::NavNode> to) {
+            if (to) {
+                routePoints.push_back(to->getLocation());
+            }
+        });
+    }
+
+    // plan again right away
+    lastPlan = TimeStamp();
+}
+
+void TilePrefetcher::update(const avitab::Location &aircraft) {
+    auto now = std::chrono::steady_clock::now();
+    xdata::Location position(aircraft.latitude, aircraft.longitude);
+
+    updateGroundSpeed(position, now);
+
+    if (now - lastPlan < std::chrono::seconds(PLAN_INTERVAL_SECONDS)) {
+        return;
+    }
+    lastPlan = now;
+
+    plan(position, aircraft.heading);
+}
+
+void TilePrefetcher::updateGroundSpeed(const xdata::Location &position, TimeStamp now) {
+    if (!hasSample) {
+        samplePosition = position;
+        sampleTime = now;
+        hasSample = true;
+        return;
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - sampleTime).count() / 1000.0;
+    if (elapsed < SPEED_SAMPLE_SECONDS) {
+        return;
+    }
+
+    // smoothed so that a single jump, e.g. after moving the aircraft, doesn't count much
+    double speed = samplePosition.distanceTo(position) / elapsed;
+    groundSpeed = 0.7 * groundSpeed + 0.3 * speed;
+
+    samplePosition = position;
+    sampleTime = now;
+}
+
+void TilePrefetcher::plan(const xdata::Location &position, double heading) {
+    std::vector<img::TileCache::TileCoords> tiles;
+
+    if (groundSpeed < MIN_GROUND_SPEED_MPS || !position.isValid()) {
+        stitcher->setPrefetchTiles(tiles);
+        return;
+    }
+
+    double distance = std::min(groundSpeed * LOOKAHEAD_SECONDS, MAX_LOOKAHEAD_M);
+
+    std::vector<xdata::Location> path;
+    if (!getRoutePath(position, distance, path)) {
+        getTrackPath(position, heading, distance, path);
+    }
+
+    // the current zoom level first, then the ones the user is most likely to switch to
+    int zoom = stitcher->getZoomLevel();
+    std::vector<int> zooms;
+    for (int z: {zoom, zoom + 1, zoom - 1}) {
+        if (z >= tileSource->getMinZoomLevel() && z <= tileSource->getMaxZoomLevel()) {
+            zooms.push_back(z);
+        }
+    }
+
+    // nearest tiles first, sampled densely enough for the finest zoom level
+    double step = getTileWidth(position, *std::max_element(zooms.begin(), zooms.end())) / 2;
+    std::set<img::TileCache::TileCoords> seen;
+
+    for (size_t i = 1; i < path.size() && tiles.size() < MAX_PREFETCH_TILES; i++) {
+        const xdata::Location &from = path[i - 1];
+        const xdata::Location &to = path[i];
+        int samples = std::max(1, (int) std::ceil(from.distanceTo(to) / step));
+        for (int s = 0; s <= samples && tiles.size() < MAX_PREFETCH_TILES; s++) {
+            xdata::Location loc = interpolate(from, to, s / (double) samples);
+            for (int z: zooms) {
+                addTiles(loc, z, seen, tiles);
+            }
+        }
+    }
+
+    if (tiles.size() > MAX_PREFETCH_TILES) {
+        tiles.resize(MAX_PREFETCH_TILES);
+    }
+
+    logger::verbose("Prefetching %d tiles along %.0f km", (int) tiles.size(), distance / 1000);
+    stitcher->setPrefetchTiles(tiles);
+}
+
+bool TilePrefetcher::getRoutePath(const xdata::Location &position, double distance, std::vector<xdata::Location> &path) const {
+    if (routePoints.size() < 2) {
+        return false;
+    }
+
+    size_t closest = 0;
+    double closestDistance = position.distanceTo(routePoints[0]);
+    for (size_t i = 1; i < routePoints.size(); i++) {
+        double d = position.distanceTo(routePoints[i]);
+        if (d < closestDistance) {
+            closest = i;
+            closestDistance = d;
+        }
+    }
+
+    // the closest waypoint is behind us if we are between it and the next one
+    size_t next = closest;
+    if (closest + 1 < routePoints.size()) {
+        double legLength = routePoints[closest].distanceTo(routePoints[closest + 1]);
+        if (position.distanceTo(routePoints[closest + 1]) < legLength) {
+            next = closest + 1;
+        }
+    }
+
+    if (closestDistance > MAX_ROUTE_DISTANCE_M && position.distanceTo(routePoints[next]) > MAX_ROUTE_DISTANCE_M) {
+        // not following the route
+        return false;
+    }
+
+    path.push_back(position);
+    double remaining = distance;
+    for (size_t i = next; i < routePoints.size() && remaining > 0; i++) {
+        double legLength = path.back().distanceTo(routePoints[i]);
+        if (legLength > remaining) {
+            // the part of the leg that is in reach
+            path.push_back(interpolate(path.back(), routePoints[i], remaining / legLength));
+            break;
+        }
+        path.push_back(routePoints[i]);
+        remaining -= legLength;
+    }
+
+    return path.size() >= 2;
+}
+
+void TilePrefetcher::getTrackPath(const xdata::Location &position, double heading, double distance, std::vector<xdata::Location> &path) const {
+    path.push_back(position);
+    path.push_back(moveBy(position, heading, distance));
+}
+
+double TilePrefetcher::getTileWidth(const xdata::Location &position, int zoom) const {
+    auto xy = tileSource->worldToXY(position.longitude, position.latitude, zoom);
+    auto left = tileSource->xyToWorld(std::floor(xy.x), xy.y, zoom);
+    auto right = tileSource->xyToWorld(std::floor(xy.x) + 1, xy.y, zoom);
+    double width = xdata::Location(left.y, left.x).distanceTo(xdata::Location(right.y, right.x));
+    return std::max(width, 100.0);
+}
+
+void TilePrefetcher::addTiles(const xdata::Location &position, int zoom, std::set<img::TileCache::TileCoords> &seen,
+        std::vector<img::TileCache::TileCoords> &tiles) const {
+    int page = stitcher->getCurrentPage();
+    auto xy = tileSource->worldToXY(position.longitude, position.latitude, zoom);
+    int centerX = (int) std::floor(xy.x);
+    int centerY = (int) std::floor(xy.y);
+
+    // the tile below the path and its neighbors, so that the corridor covers the visible map
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            img::TileCache::TileCoords coords(page, centerX + dx, centerY + dy, zoom);
+            if (!tileSource->isTileValid(page, centerX + dx, centerY + dy, zoom)) {
+                continue;
+            }
+            if (seen.insert(coords).second) {
+                tiles.push_back(coords);
+            }
+        }
+    }
+}
+
+xdata::Location TilePrefetcher::moveBy(const xdata::Location &from, double bearingDegrees, double meters) {
+    // destination on a great circle
+    double R = 6371000;
+    double delta = meters / R;
+    double theta = bearingDegrees * M_PI / 180.0;
+    double phi1 = from.latitude * M_PI / 180.0;
+    double lambda1 = from.longitude * M_PI / 180.0;
+
+    double phi2 = std::asin(std::sin(phi1) * std::cos(delta) + std::cos(phi1) * std::sin(delta) * std::cos(theta));
+    double lambda2 = lambda1 + std::atan2(std::sin(theta) * std::sin(delta) * std::cos(phi1),
+                                          std::cos(delta) - std::sin(phi1) * std::sin(phi2));
+
+    double lon = std::fmod(lambda2 * 180.0 / M_PI + 540.0, 360.0) - 180.0;
+    return xdata::Location(phi2 * 180.0 / M_PI, lon);
+}
+
+xdata::Location TilePrefetcher::interpolate(const xdata::Location &from, const xdata::Location &to, double t) {
+    // the short way, i.e. across the antimeridian if the longitudes are more than 180 degrees apart
+    double dLon = to.longitude - from.longitude;
+    if (dLon > 180) {
+        dLon -= 360;
+    } else if (dLon < -180) {
+        dLon += 360;
+    }
+
+    double lon = std::fmod(from.longitude + t * dLon + 540.0, 360.0) - 180.0;
+    return xdata::Location(from.latitude + t * (to.latitude - from.latitude), lon);
+}
+
+} /* namespace maps */
@@ -0,0 +1,81 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SRC_MAPS_TILEPREFETCHER_H_
+#define SRC_MAPS_TILEPREFETCHER_H_
+
+#include <memory>
+#include <vector>
+#include <set>
+#include <chrono>
+#include "src/libimg/stitcher/Stitcher.h"
+#include "src/libxdata/router/Route.h"
+#include "src/libxdata/world/models/Location.h"
+#include "src/environment/Environment.h"
+
+namespace maps {
+
+/*
+ * Fetches the tiles ahead of the aircraft into the disk cache so that they
+ * are there when the map gets to them. Follows the active route if the
+ * aircraft is on it, otherwise the current track.
+ */
+class TilePrefetcher {
+public:
+    TilePrefetcher(std::shared_ptr<img::Stitcher> stitcher);
+    void setRoute(std::shared_ptr<xdata::Route> route);
+
+    // Call periodically with the own aircraft's position
+    void update(const avitab::Location &aircraft);
+
+private:
+    using TimeStamp = std::chrono::time_point<std::chrono::steady_clock>;
+
+    static constexpr const int PLAN_INTERVAL_SECONDS = 5;
+    static constexpr const int SPEED_SAMPLE_SECONDS = 1;
+    static constexpr const double LOOKAHEAD_SECONDS = 600;
+    static constexpr const double MAX_LOOKAHEAD_M = 150000;
+    static constexpr const double MIN_GROUND_SPEED_MPS = 15; // about 30 knots, i.e. not taxiing
+    static constexpr const double MAX_ROUTE_DISTANCE_M = 20000; // about 10 NM
+    static constexpr const size_t MAX_PREFETCH_TILES = 400;
+
+    std::shared_ptr<img::Stitcher> stitcher;
+    std::shared_ptr<img::TileSource> tileSource;
+    std::shared_ptr<xdata::Route> route;
+    std::vector<xdata::Location> routePoints;
+
+    bool hasSample = false;
+    xdata::Location samplePosition;
+    TimeStamp sampleTime;
+    double groundSpeed = 0; // m/s
+    TimeStamp lastPlan;
+
+    void updateGroundSpeed(const xdata::Location &position, TimeStamp now);
+    void plan(const xdata::Location &position, double heading);
+    bool getRoutePath(const xdata::Location &position, double distance, std::vector<xdata::Location> &path) const;
+    void getTrackPath(const xdata::Location &position, double heading, double distance, std::vector<xdata::Location> &path) const;
+    double getTileWidth(const xdata::Location &position, int zoom) const;
+    void addTiles(const xdata::Location &position, int zoom, std::set<img::TileCache::TileCoords> &seen,
+            std::vector<img::TileCache::TileCoords> &tiles) const;
+
+    static xdata::Location moveBy(const xdata::Location &from, double bearingDegrees, double meters);
+    static xdata::Location interpolate(const xdata::Location &from, const xdata::Location &to, double t);
+};
+
+} /* namespace maps */
+
+#endif /* SRC_MAPS_TILEPREFETCHER_H_ */
@@ -19,6 +19,7 @@
 #include <stdexcept>
 #include <cmath>
 #include "EPSGSource.h"
+#include "WebMercator.h"
 #include "src/platform/Platform.h"
 
 namespace maps {
@@ -86,6 +87,11 @@ void EPSGSource::cancelPendingLoads() {
 void EPSGSource::resumeLoading() {
 }
 
+int EPSGSource::getMaxParallelLoads() {
+    // tiles are independent files
+    return std::numeric_limits<int>::max();
+}
+
 int EPSGSource::getPageCount() {
     return 1;
 }
@@ -128,27 +134,15 @@ std::unique_ptr<img::Image> EPSGSource::loadTileImage(int page, int x, int y, in
 }
 
 img::Point<double> EPSGSource::worldToXY(double lon, double lat, int zoom) {
-    double zp = std::pow(2.0, zoom);
-    double x = (lon + 180.0) / 360.0 * zp;
-    double y = (1.0 - std::log(std::tan(lat * M_PI / 180.0) +
-           1.0 / std::cos(lat * M_PI / 180.0)) / M_PI) / 2.0 * zp;
-    return img::Point<double>{x, y};
+    return WebMercator::worldToXY(lon, lat, zoom);
 }
 
-img::Point<double> EPSGSource::xyToWorld(double x, double y, int zoom) {
-    double zp = std::pow(2.0, zoom);
-    double plainLon = x / zp * 360.0 - 180;
-    double lon = std::fmod(plainLon, 360.0);
-    if (lon > 180.0) {
-        lon -= 360.0;
-    } else if (lon <= -180.0) {
-        lon += 360.0;
-    }
-
-    double n = M_PI - 2.0 * M_PI * y / zp;
-    double lat = 180.0 / M_PI * std::atan(0.5 * (std::exp(n) - std::exp(-n)));
+void EPSGSource::worldToXYBatch(const double *lon, const double *lat, double *x, double *y, size_t count, int zoom) {
+    WebMercator::worldToXY(lon, lat, x, y, count, zoom);
+}
 
-    return img::Point<double>{lon, lat};
+img::Point<double> EPSGSource::xyToWorld(double x, double y, int zoom) {
+    return WebMercator::xyToWorld(x, y, zoom);
 }
 
 } /* namespace maps */
@@ -40,6 +40,7 @@ public:
     // Control the underlying loader
     void cancelPendingLoads() override;
     void resumeLoading() override;
+    int getMaxParallelLoads() override;
 
     // Query and load tile information
     int getPageCount() override;
@@ -49,6 +50,7 @@ public:
 
     // If world position is supported
     img::Point<double> worldToXY(double lon, double lat, int zoom) override;
+    void worldToXYBatch(const double *lon, const double *lat, double *x, double *y, size_t count, int zoom) override;
     img::Point<double> xyToWorld(double x, double y, int zoom) override;
 
 private:
@@ -18,6 +18,7 @@
 #include <stdexcept>
 #include <sstream>
 #include <cmath>
+#include <algorithm>
 #include <geovalues.h>
 #include "GeoTIFFSource.h"
 #include "src/Logger.h"
@@ -25,7 +26,9 @@
 
 namespace maps {
 
-GeoTIFFSource::GeoTIFFSource(const std::string &utf8File) {
+GeoTIFFSource::GeoTIFFSource(const std::string &utf8File):
+    cachePrefix("geotiff/" + platform::getFileNameFromPath(utf8File) + "-" + platform::getFileFingerprint(utf8File) + "/")
+{
     tiff.loadTIFF(utf8File);
     gtif = GTIFNew(tiff.getXtiffHandle());
     if (!gtif) {
@@ -112,7 +115,7 @@ std::string GeoTIFFSource::getUniqueTileName(int page, int x, int y, int zoom) {
     }
 
     std::ostringstream nameStream;
-    nameStream << zoom << "/" << x << "/" << y;
+    nameStream << cachePrefix << zoom << "/" << x << "/" << y;
     return nameStream.str();
 }
 
@@ -138,6 +141,10 @@ void GeoTIFFSource::cancelPendingLoads() {
 void GeoTIFFSource::resumeLoading() {
 }
 
+bool GeoTIFFSource::supportsSeeding() {
+    return true;
+}
+
 bool GeoTIFFSource::supportsWorldCoords() {
     return true;
 }
@@ -156,6 +163,25 @@ img::Point<double> GeoTIFFSource::worldToXY(double lon, double lat, int zoom) {
     return img::Point<double>{x, y};
 }
 
+void GeoTIFFSource::worldToXYBatch(const double *lon, const double *lat, double *x, double *y, size_t count, int zoom) {
+    if (count == 0) {
+        return;
+    }
+
+    std::copy(lon, lon + count, x);
+    std::copy(lat, lat + count, y);
+
+    // proj transforms the whole array in one call, the image transform is a cheap affine one
+    GTIFProj4FromLatLong(&defn, (int) count, x, y);
+
+    auto scale = zoomToScale(zoom);
+    for (size_t i = 0; i < count; i++) {
+        GTIFPCSToImage(gtif, &x[i], &y[i]);
+        x[i] = x[i] / tileSize * scale;
+        y[i] = y[i] / tileSize * scale;
+    }
+}
+
 img::Point<double> GeoTIFFSource::xyToWorld(double x, double y, int zoom) {
     auto scale = zoomToScale(zoom);
 
@@ -45,14 +45,17 @@ public:
     std::unique_ptr<img::Image> loadTileImage(int page, int x, int y, int zoom) override;
     void cancelPendingLoads() override;
     void resumeLoading() override;
+    bool supportsSeeding() override;
 
     bool supportsWorldCoords() override;
     img::Point<double> worldToXY(double lon, double lat, int zoom) override;
+    void worldToXYBatch(const double *lon, const double *lat, double *x, double *y, size_t count, int zoom) override;
     img::Point<double> xyToWorld(double x, double y, int zoom) override;
 
     ~GeoTIFFSource();
 private:
     int tileSize = 512;
+    std::string cachePrefix;
 
     img::XTiffImage tiff;
     GTIF *gtif{};
@@ -16,6 +16,7 @@
  *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include "NavigraphSource.h"
+#include "WebMercator.h"
 #include <sstream>
 #include <stdexcept>
 #include <cmath>
@@ -72,27 +73,15 @@ img::Point<double> NavigraphSource::transformZoomedPoint(int page, double oldX,
 }
 
 img::Point<double> NavigraphSource::worldToXY(double lon, double lat, int zoom) {
-    double zp = std::pow(2.0, zoom);
-    double x = (lon + 180.0) / 360.0 * zp;
-    double y = (1.0 - std::log(std::tan(lat * M_PI / 180.0) +
-           1.0 / std::cos(lat * M_PI / 180.0)) / M_PI) / 2.0 * zp;
-    return img::Point<double>{x, y};
+    return WebMercator::worldToXY(lon, lat, zoom);
 }
 
-img::Point<double> NavigraphSource::xyToWorld(double x, double y, int zoom) {
-    double zp = std::pow(2.0, zoom);
-    double plainLon = x / zp * 360.0 - 180;
-    double lon = std::fmod(plainLon, 360.0);
-    if (lon > 180.0) {
-        lon -= 360.0;
-    } else if (lon <= -180.0) {
-        lon += 360.0;
-    }
-
-    double n = M_PI - 2.0 * M_PI * y / zp;
-    double lat = 180.0 / M_PI * std::atan(0.5 * (std::exp(n) - std::exp(-n)));
+void NavigraphSource::worldToXYBatch(const double *lon, const double *lat, double *x, double *y, size_t count, int zoom) {
+    WebMercator::worldToXY(lon, lat, x, y, count, zoom);
+}
 
-    return img::Point<double>{lon, lat};
+img::Point<double> NavigraphSource::xyToWorld(double x, double y, int zoom) {
+    return WebMercator::xyToWorld(x, y, zoom);
 }
 
 int NavigraphSource::getPageCount() {
@@ -144,9 +133,21 @@ std::string NavigraphSource::getUniqueTileName(int page, int x, int y, int zoom)
 std::unique_ptr<img::Image> NavigraphSource::loadTileImage(int page, int x, int y, int zoom) {
     auto key = navigraph->getEnrouteKey();
 
-    cancelToken = false;
     std::string path = getUniqueTileName(page, x, y, zoom);
     auto data = downloader.download("https://enroute.charts.api.navigraph.com/" + key + path, cancelToken);
+    return decodeTileData(page, x, y, zoom, data);
+}
+
+bool NavigraphSource::startTileDownload(int page, int x, int y, int zoom, TileDataCallback onDone) {
+    auto key = navigraph->getEnrouteKey();
+
+    std::string path = getUniqueTileName(page, x, y, zoom);
+    downloader.downloadAsync("https://enroute.charts.api.navigraph.com/" + key + path, cancelToken, onDone);
+    return true;
+}
+
+std::unique_ptr<img::Image> NavigraphSource::decodeTileData(int page, int x, int y, int zoom, std::vector<uint8_t> &data) {
+    // don't keep the encoded data so that the tiles are never written to the disk cache
     auto image = std::make_unique<img::Image>();
     image->loadEncodedData(data, false);
     return image;
@@ -160,6 +161,10 @@ void NavigraphSource::resumeLoading() {
     cancelToken = false;
 }
 
+int NavigraphSource::getMaxParallelLoads() {
+    return MAX_PARALLEL_DOWNLOADS;
+}
+
 std::string NavigraphSource::getCopyrightInfo() {
     return "(c) Navigraph | Jeppesen - Not for Navigational Use";
 }
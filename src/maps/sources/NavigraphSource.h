@@ -40,22 +40,29 @@ public:
     // Control the underlying loader
     void cancelPendingLoads() override;
     void resumeLoading() override;
+    int getMaxParallelLoads() override;
 
     // Query and load tile information
     int getPageCount() override;
     bool isTileValid(int page, int x, int y, int zoom) override;
     std::string getUniqueTileName(int page, int x, int y, int zoom) override;
     std::unique_ptr<img::Image> loadTileImage(int page, int x, int y, int zoom) override;
+    bool startTileDownload(int page, int x, int y, int zoom, TileDataCallback onDone) override;
+    std::unique_ptr<img::Image> decodeTileData(int page, int x, int y, int zoom, std::vector<uint8_t> &data) override;
 
     // If world position is supported
     img::Point<double> worldToXY(double lon, double lat, int zoom) override;
+    void worldToXYBatch(const double *lon, const double *lat, double *x, double *y, size_t count, int zoom) override;
     img::Point<double> xyToWorld(double x, double y, int zoom) override;
 
     std::string getCopyrightInfo() override;
 private:
+    // requests in flight, the download engine limits the connections per host
+    static constexpr const int MAX_PARALLEL_DOWNLOADS = 8;
+
     std::shared_ptr<navigraph::NavigraphAPI> navigraph;
     bool dayMode, highRoutes;
-    bool cancelToken = false;
+    std::atomic_bool cancelToken { false };
     Downloader downloader;
 };
 
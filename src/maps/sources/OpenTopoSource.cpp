@@ -16,6 +16,7 @@
  *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 #include "OpenTopoSource.h"
+#include "WebMercator.h"
 #include <sstream>
 #include <stdexcept>
 #include <cmath>
@@ -63,27 +64,15 @@ img::Point<double> OpenTopoSource::transformZoomedPoint(int page, double oldX, d
 }
 
 img::Point<double> OpenTopoSource::worldToXY(double lon, double lat, int zoom) {
-    double zp = std::pow(2.0, zoom);
-    double x = (lon + 180.0) / 360.0 * zp;
-    double y = (1.0 - std::log(std::tan(lat * M_PI / 180.0) +
-           1.0 / std::cos(lat * M_PI / 180.0)) / M_PI) / 2.0 * zp;
-    return img::Point<double>{x, y};
+    return WebMercator::worldToXY(lon, lat, zoom);
 }
 
-img::Point<double> OpenTopoSource::xyToWorld(double x, double y, int zoom) {
-    double zp = std::pow(2.0, zoom);
-    double plainLon = x / zp * 360.0 - 180;
-    double lon = std::fmod(plainLon, 360.0);
-    if (lon > 180.0) {
-        lon -= 360.0;
-    } else if (lon <= -180.0) {
-        lon += 360.0;
-    }
-
-    double n = M_PI - 2.0 * M_PI * y / zp;
-    double lat = 180.0 / M_PI * std::atan(0.5 * (std::exp(n) - std::exp(-n)));
+void OpenTopoSource::worldToXYBatch(const double *lon, const double *lat, double *x, double *y, size_t count, int zoom) {
+    WebMercator::worldToXY(lon, lat, x, y, count, zoom);
+}
 
-    return img::Point<double>{lon, lat};
+img::Point<double> OpenTopoSource::xyToWorld(double x, double y, int zoom) {
+    return WebMercator::xyToWorld(x, y, zoom);
 }
 
 int OpenTopoSource::getPageCount() {
@@ -122,14 +111,20 @@ std::string OpenTopoSource::getUniqueTileName(int page, int x, int y, int zoom)
 }
 
 std::unique_ptr<img::Image> OpenTopoSource::loadTileImage(int page, int x, int y, int zoom) {
-    cancelToken = false;
     std::string path = getUniqueTileName(page, x, y, zoom);
     auto data = downloader.download("https://" + path, cancelToken);
+
     auto image = std::make_unique<img::Image>();
     image->loadEncodedData(data, true);
     return image;
 }
 
+bool OpenTopoSource::startTileDownload(int page, int x, int y, int zoom, TileDataCallback onDone) {
+    std::string path = getUniqueTileName(page, x, y, zoom);
+    downloader.downloadAsync("https://" + path, cancelToken, onDone);
+    return true;
+}
+
 void OpenTopoSource::cancelPendingLoads() {
     cancelToken = true;
 }
@@ -138,6 +133,18 @@ void OpenTopoSource::resumeLoading() {
     cancelToken = false;
 }
 
+int OpenTopoSource::getMaxParallelLoads() {
+    return MAX_PARALLEL_DOWNLOADS;
+}
+
+bool OpenTopoSource::supportsPrefetch() {
+    return true;
+}
+
+bool OpenTopoSource::supportsSeeding() {
+    return true;
+}
+
 std::string OpenTopoSource::getCopyrightInfo() {
     return "Map Data (c) OpenStreetMap, SRTM - Map Style (c) OpenTopoMap (CC-BY-SA)";
 }
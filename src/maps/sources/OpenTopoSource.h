@@ -18,6 +18,10 @@
 #ifndef SRC_MAPS_OPENTOPOSOURCE_H_
 #define SRC_MAPS_OPENTOPOSOURCE_H_
 
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <memory>
 #include "src/libimg/stitcher/TileSource.h"
 #include "src/maps/Downloader.h"
 
@@ -37,20 +41,28 @@ public:
     // Control the underlying loader
     void cancelPendingLoads() override;
     void resumeLoading() override;
+    int getMaxParallelLoads() override;
+    bool supportsPrefetch() override;
+    bool supportsSeeding() override;
 
     // Query and load tile information
     int getPageCount() override;
     bool isTileValid(int page, int x, int y, int zoom) override;
     std::string getUniqueTileName(int page, int x, int y, int zoom) override;
     std::unique_ptr<img::Image> loadTileImage(int page, int x, int y, int zoom) override;
+    bool startTileDownload(int page, int x, int y, int zoom, TileDataCallback onDone) override;
 
     // If world position is supported
     img::Point<double> worldToXY(double lon, double lat, int zoom) override;
+    void worldToXYBatch(const double *lon, const double *lat, double *x, double *y, size_t count, int zoom) override;
     img::Point<double> xyToWorld(double x, double y, int zoom) override;
 
     std::string getCopyrightInfo() override;
 private:
-    bool cancelToken = false;
+    // requests in flight, the download engine limits the connections per host to be nice to the tile servers
+    static constexpr const int MAX_PARALLEL_DOWNLOADS = 16;
+
+    std::atomic_bool cancelToken { false };
     Downloader downloader;
 };
 
@@ -23,8 +23,11 @@
 
 namespace maps {
 
+// Different documents must not share tiles in the cache, even if they have the same
+// name or replace a file that was already cached
 PDFSource::PDFSource(const std::string& file):
     utf8FileName(file),
+    cachePrefix("pdf/" + platform::getFileNameFromPath(file) + "-" + platform::getFileFingerprint(file) + "/"),
     rasterizer(file)
 {
     try {
@@ -35,6 +38,7 @@ PDFSource::PDFSource(const std::string& file):
 }
 
 PDFSource::PDFSource(const std::vector<uint8_t> &pdfData):
+    cachePrefix("pdf/data-" + platform::hashToHex(platform::hashBytes(pdfData.data(), pdfData.size())) + "/"),
     rasterizer(pdfData)
 {
 }
@@ -104,7 +108,10 @@ bool PDFSource::isTileValid(int page, int x, int y, int zoom) {
 
 std::string PDFSource::getUniqueTileName(int page, int x, int y, int zoom) {
     std::ostringstream nameStream;
-    nameStream << zoom << "/" << x << "/" << y << "/" << page;
+    nameStream << cachePrefix << zoom << "/" << x << "/" << y << "/" << page;
+    if (nightMode) {
+        nameStream << "n";
+    }
     return nameStream.str();
 }
 
@@ -118,6 +125,10 @@ void PDFSource::cancelPendingLoads() {
 void PDFSource::resumeLoading() {
 }
 
+bool PDFSource::supportsSeeding() {
+    return true;
+}
+
 void PDFSource::attachCalibration1(double x, double y, double lat, double lon, int zoom) {
     int tileSize = rasterizer.getTileSize();
     double normX = x * tileSize / rasterizer.getPageWidth(0, zoom);
@@ -45,6 +45,7 @@ public:
     std::unique_ptr<img::Image> loadTileImage(int page, int x, int y, int zoom) override;
     void cancelPendingLoads() override;
     void resumeLoading() override;
+    bool supportsSeeding() override;
 
     bool supportsWorldCoords() override;
     img::Point<double> worldToXY(double lon, double lat, int zoom) override;
@@ -57,6 +58,7 @@ public:
 
 private:
     std::string utf8FileName;
+    std::string cachePrefix;
     img::Rasterizer rasterizer;
     Calibration calibration;
     bool nightMode = false;
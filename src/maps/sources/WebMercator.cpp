@@ -0,0 +1,63 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include <cmath>
+#include "WebMercator.h"
+
+namespace maps {
+
+img::Point<double> WebMercator::worldToXY(double lon, double lat, int zoom) {
+    double zp = std::pow(2.0, zoom);
+    double x = (lon + 180.0) / 360.0 * zp;
+    double y = (1.0 - std::log(std::tan(lat * M_PI / 180.0) +
+           1.0 / std::cos(lat * M_PI / 180.0)) / M_PI) / 2.0 * zp;
+    return img::Point<double>{x, y};
+}
+
+img::Point<double> WebMercator::xyToWorld(double x, double y, int zoom) {
+    double zp = std::pow(2.0, zoom);
+    double plainLon = x / zp * 360.0 - 180;
+    double lon = std::fmod(plainLon, 360.0);
+    if (lon > 180.0) {
+        lon -= 360.0;
+    } else if (lon <= -180.0) {
+        lon += 360.0;
+    }
+
+    double n = M_PI - 2.0 * M_PI * y / zp;
+    double lat = 180.0 / M_PI * std::atan(0.5 * (std::exp(n) - std::exp(-n)));
+
+    return img::Point<double>{lon, lat};
+}
+
+void WebMercator::worldToXY(const double *lon, const double *lat, double *x, double *y, size_t count, int zoom) {
+    double zp = std::pow(2.0, zoom);
+
+    // Same terms as the single point version so both agree to the last bit.
+    // The longitude pass is plain arithmetic over the whole array.
+    for (size_t i = 0; i < count; i++) {
+        x[i] = (lon[i] + 180.0) / 360.0 * zp;
+    }
+
+    double yScale = zp / 2.0;
+    for (size_t i = 0; i < count; i++) {
+        double latRad = lat[i] * M_PI / 180.0;
+        y[i] = (1.0 - std::log(std::tan(latRad) + 1.0 / std::cos(latRad)) / M_PI) * yScale;
+    }
+}
+
+} /* namespace maps */
@@ -0,0 +1,38 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SRC_MAPS_SOURCES_WEBMERCATOR_H_
+#define SRC_MAPS_SOURCES_WEBMERCATOR_H_
+
+#include <cstddef>
+#include "src/libimg/stitcher/TileSource.h"
+
+namespace maps {
+
+// Spherical Web Mercator as used by slippy map tiles, x and y in tiles at the given zoom
+class WebMercator {
+public:
+    static img::Point<double> worldToXY(double lon, double lat, int zoom);
+    static img::Point<double> xyToWorld(double x, double y, int zoom);
+
+    // Batched worldToXY, kept free of calls in the linear part so the compiler can vectorize it
+    static void worldToXY(const double *lon, const double *lat, double *x, double *y, size_t count, int zoom);
+};
+
+} /* namespace maps */
+
+#endif /* SRC_MAPS_SOURCES_WEBMERCATOR_H_ */
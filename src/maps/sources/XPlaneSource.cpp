@@ -21,6 +21,7 @@
 #include <cmath>
 #include <cstdio>
 #include <memory>
+#include <limits>
 #include "src/libimg/DDSImage.h"
 #include "src/platform/Platform.h"
 #include "src/Logger.h"
@@ -93,7 +94,7 @@ std::string XPlaneSource::getUniqueTileName(int page, int x, int y, int zoom) {
     }
 
     std::ostringstream nameStream;
-    nameStream << zoom << "/" << x << "/" << y;
+    nameStream << "xplane/" << zoom << "/" << x << "/" << y;
     return nameStream.str();
 }
 
@@ -134,6 +135,16 @@ void XPlaneSource::cancelPendingLoads() {
 void XPlaneSource::resumeLoading() {
 }
 
+int XPlaneSource::getMaxParallelLoads() {
+    // each tile is decoded from its own DDS file
+    return std::numeric_limits<int>::max();
+}
+
+bool XPlaneSource::supportsSeeding() {
+    // decoding the DDS mipmaps takes longer than loading a PNG
+    return true;
+}
+
 img::Point<double> XPlaneSource::worldToXY(double lon, double lat, int zoom) {
     double x = (lon + 180) / 10;
     double y = (-lat + 90) / 10;
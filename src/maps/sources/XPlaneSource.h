@@ -40,6 +40,8 @@ public:
     std::unique_ptr<img::Image> loadTileImage(int page, int x, int y, int zoom) override;
     void cancelPendingLoads() override;
     void resumeLoading() override;
+    int getMaxParallelLoads() override;
+    bool supportsSeeding() override;
 
     bool supportsWorldCoords() override;
     img::Point<double> worldToXY(double lon, double lat, int zoom) override;
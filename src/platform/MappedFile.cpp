@@ -0,0 +1,131 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifdef _WIN32
+#   define WIN32_LEAN_AND_MEAN
+#   include <windows.h>
+#   include <locale>
+#   include <codecvt>
+#else
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
+
+#include <stdexcept>
+#include "MappedFile.h"
+
+namespace platform {
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string& utf8Path) {
+    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>, wchar_t> convert;
+    std::wstring widePath = convert.from_bytes(utf8Path);
+
+    fileHandle = CreateFileW(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        fileHandle = nullptr;
+        throw std::runtime_error("Couldn't open file: " + utf8Path);
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize)) {
+        CloseHandle(fileHandle);
+        throw std::runtime_error("Couldn't get size of file: " + utf8Path);
+    }
+    size = fileSize.QuadPart;
+
+    if (size == 0) {
+        // empty files can't be mapped
+        return;
+    }
+
+    mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle) {
+        data = (const char *) MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    }
+
+    if (!data) {
+        if (mappingHandle) {
+            CloseHandle(mappingHandle);
+        }
+        CloseHandle(fileHandle);
+        throw std::runtime_error("Couldn't map file: " + utf8Path);
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (data) {
+        UnmapViewOfFile(data);
+    }
+    if (mappingHandle) {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle) {
+        CloseHandle(fileHandle);
+    }
+}
+#else
+MappedFile::MappedFile(const std::string& utf8Path) {
+    fd = open(utf8Path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Couldn't open file: " + utf8Path);
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("Couldn't get size of file: " + utf8Path);
+    }
+    size = st.st_size;
+
+    if (size == 0) {
+        // empty files can't be mapped
+        return;
+    }
+
+    void *mem = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mem == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("Couldn't map file: " + utf8Path);
+    }
+
+    // the parsers read the files front to back
+    madvise(mem, size, MADV_SEQUENTIAL);
+    data = (const char *) mem;
+}
+
+MappedFile::~MappedFile() {
+    if (data) {
+        munmap((void *) data, size);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+#endif
+
+const char* MappedFile::getData() const {
+    return data;
+}
+
+size_t MappedFile::getSize() const {
+    return size;
+}
+
+} /* namespace platform */
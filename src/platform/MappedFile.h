@@ -0,0 +1,50 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SRC_PLATFORM_MAPPEDFILE_H_
+#define SRC_PLATFORM_MAPPEDFILE_H_
+
+#include <string>
+#include <cstddef>
+
+namespace platform {
+
+// Maps a whole file read-only into memory
+class MappedFile {
+public:
+    MappedFile(const std::string &utf8Path);
+    MappedFile(const MappedFile &other) = delete;
+    MappedFile &operator=(const MappedFile &other) = delete;
+
+    const char *getData() const;
+    size_t getSize() const;
+
+    ~MappedFile();
+private:
+    const char *data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void *fileHandle = nullptr;
+    void *mappingHandle = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+} /* namespace platform */
+
+#endif /* SRC_PLATFORM_MAPPEDFILE_H_ */
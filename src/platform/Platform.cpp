@@ -30,6 +30,7 @@
 #include <dirent.h>
 #include <sys/stat.h>
 #include <cstdlib>
+#include <cstdio>
 #include <climits>
 #include <libgen.h>
 #include <algorithm>
@@ -188,6 +189,41 @@ bool fileExists(const std::string& utf8Path) {
     return fs::exists(path);
 }
 
+uint64_t hashBytes(const void *data, size_t len, uint64_t hash) {
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < len; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+std::string hashToHex(uint64_t hash) {
+    char buf[17];
+    std::snprintf(buf, sizeof(buf), "%016llx", (unsigned long long) hash);
+    return buf;
+}
+
+std::string getFileFingerprint(const std::string& utf8Path) {
+    // the content and not the path or date, so that copies of a file share their data
+    fs::ifstream in(fs::u8path(utf8Path), std::ios::in | std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Couldn't open " + utf8Path);
+    }
+
+    std::vector<char> buf(1024 * 1024);
+    uint64_t hash = HASH_SEED;
+    while (in) {
+        in.read(buf.data(), buf.size());
+        hash = hashBytes(buf.data(), in.gcount(), hash);
+    }
+
+    if (in.bad()) {
+        throw std::runtime_error("Couldn't read " + utf8Path);
+    }
+    return hashToHex(hash);
+}
+
 void mkdir(const std::string& utf8Path) {
     auto path = fs::u8path(utf8Path);
     fs::create_directory(path);
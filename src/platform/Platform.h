@@ -20,6 +20,7 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
 #include <cstdarg>
 #include <chrono>
 #include <fstream>
@@ -92,6 +93,14 @@ std::string realPath(const std::string &utf8Path);
 std::string getFileNameFromPath(const std::string &utf8Path);
 std::string getDirNameFromPath(const std::string &utf8Path);
 bool fileExists(const std::string &utf8Path);
+
+// 64 bit FNV-1a, pass the previous result to continue a hash over several blocks
+constexpr const uint64_t HASH_SEED = 0xcbf29ce484222325;
+uint64_t hashBytes(const void *data, size_t len, uint64_t hash = HASH_SEED);
+std::string hashToHex(uint64_t hash);
+
+// Hash of the file's content, e.g. to name cached data derived from the file
+std::string getFileFingerprint(const std::string &utf8Path);
 void mkdir(const std::string &utf8Path);
 void mkpath(const std::string &utf8Path);
 void removeFile(const std::string &utf8Path);
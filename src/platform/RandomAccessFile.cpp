@@ -0,0 +1,142 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifdef _WIN32
+#   define WIN32_LEAN_AND_MEAN
+#   include <windows.h>
+#   include <locale>
+#   include <codecvt>
+#else
+#   include <fcntl.h>
+#   include <unistd.h>
+#   include <cerrno>
+#endif
+
+#include <stdexcept>
+#include <algorithm>
+#include "RandomAccessFile.h"
+
+namespace platform {
+
+#ifdef _WIN32
+RandomAccessFile::RandomAccessFile(const std::string& utf8Path):
+    path(utf8Path)
+{
+    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>, wchar_t> convert;
+    std::wstring widePath = convert.from_bytes(utf8Path);
+
+    fileHandle = CreateFileW(widePath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                    nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        fileHandle = nullptr;
+        throw std::runtime_error("Couldn't open file: " + utf8Path);
+    }
+}
+
+bool RandomAccessFile::readAt(uint64_t offset, void* buf, size_t len) {
+    char *dst = (char *) buf;
+    while (len > 0) {
+        OVERLAPPED ov {};
+        ov.Offset = (DWORD) (offset & 0xFFFFFFFF);
+        ov.OffsetHigh = (DWORD) (offset >> 32);
+
+        DWORD chunk = (DWORD) std::min<size_t>(len, 0x40000000);
+        DWORD numRead = 0;
+        if (!ReadFile(fileHandle, dst, chunk, &numRead, &ov) || numRead == 0) {
+            return false;
+        }
+        dst += numRead;
+        offset += numRead;
+        len -= numRead;
+    }
+    return true;
+}
+
+void RandomAccessFile::writeAt(uint64_t offset, const void* buf, size_t len) {
+    const char *src = (const char *) buf;
+    while (len > 0) {
+        OVERLAPPED ov {};
+        ov.Offset = (DWORD) (offset & 0xFFFFFFFF);
+        ov.OffsetHigh = (DWORD) (offset >> 32);
+
+        DWORD chunk = (DWORD) std::min<size_t>(len, 0x40000000);
+        DWORD numWritten = 0;
+        if (!WriteFile(fileHandle, src, chunk, &numWritten, &ov) || numWritten == 0) {
+            throw std::runtime_error("Couldn't write to file: " + path);
+        }
+        src += numWritten;
+        offset += numWritten;
+        len -= numWritten;
+    }
+}
+
+RandomAccessFile::~RandomAccessFile() {
+    if (fileHandle) {
+        CloseHandle(fileHandle);
+    }
+}
+#else
+RandomAccessFile::RandomAccessFile(const std::string& utf8Path):
+    path(utf8Path)
+{
+    fd = open(utf8Path.c_str(), O_RDWR);
+    if (fd < 0) {
+        throw std::runtime_error("Couldn't open file: " + utf8Path);
+    }
+}
+
+bool RandomAccessFile::readAt(uint64_t offset, void* buf, size_t len) {
+    char *dst = (char *) buf;
+    while (len > 0) {
+        ssize_t numRead = pread(fd, dst, len, offset);
+        if (numRead < 0 && errno == EINTR) {
+            continue;
+        }
+        if (numRead <= 0) {
+            return false;
+        }
+        dst += numRead;
+        offset += numRead;
+        len -= numRead;
+    }
+    return true;
+}
+
+void RandomAccessFile::writeAt(uint64_t offset, const void* buf, size_t len) {
+    const char *src = (const char *) buf;
+    while (len > 0) {
+        ssize_t numWritten = pwrite(fd, src, len, offset);
+        if (numWritten < 0 && errno == EINTR) {
+            continue;
+        }
+        if (numWritten <= 0) {
+            throw std::runtime_error("Couldn't write to file: " + path);
+        }
+        src += numWritten;
+        offset += numWritten;
+        len -= numWritten;
+    }
+}
+
+RandomAccessFile::~RandomAccessFile() {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+#endif
+
+} /* namespace platform */
@@ -0,0 +1,51 @@
+/*
+ *   AviTab - Aviator's Virtual Tablet
+ *   Copyright (C) 2018 Folke Will <folko@solhost.org>
+ *
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU Affero General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Affero General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Affero General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef SRC_PLATFORM_RANDOMACCESSFILE_H_
+#define SRC_PLATFORM_RANDOMACCESSFILE_H_
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace platform {
+
+// Reads and writes an existing file at explicit offsets. There is no shared
+// file position, so several threads can read at the same time.
+class RandomAccessFile {
+public:
+    RandomAccessFile(const std::string &utf8Path);
+    RandomAccessFile(const RandomAccessFile &other) = delete;
+    RandomAccessFile &operator=(const RandomAccessFile &other) = delete;
+
+    // false if the file ends before len bytes could be read
+    bool readAt(uint64_t offset, void *buf, size_t len);
+    void writeAt(uint64_t offset, const void *buf, size_t len);
+
+    ~RandomAccessFile();
+private:
+    std::string path;
+#ifdef _WIN32
+    void *fileHandle = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+} /* namespace platform */
+
+#endif /* SRC_PLATFORM_RANDOMACCESSFILE_H_ */